@@ -5,6 +5,7 @@
 #include <strsafe.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <cmath>
 #include <cstdlib>
@@ -13,23 +14,48 @@
 #include <fstream>
 #include <iterator>
 #include <limits>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <system_error>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "utf8_text.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define BACKREST_WATCHER_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#if defined(BACKREST_WATCHER_X86_SIMD) && (defined(__GNUC__) || defined(__clang__))
+#define BACKREST_WATCHER_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define BACKREST_WATCHER_TARGET_AVX2
+#endif
+
 #pragma comment(lib, "comctl32.lib")
 
 namespace {
 
 constexpr UINT kTrayIconId = 1;
 constexpr UINT kTrayMessage = WM_APP + 1;
+constexpr UINT kLogChangedMessage = WM_APP + 2;
+constexpr WPARAM kLogChangeNotifierStopped = 1;
+constexpr UINT kScanResultsMessage = WM_APP + 3;
+constexpr DWORD kScannerShutdownTimeoutMs = 10000;
 constexpr UINT_PTR kMonitorTimerId = 1;
 constexpr UINT_PTR kBlinkTimerId = 2;
 constexpr UINT kDefaultMonitorIntervalMs = 1500;
 constexpr UINT kBlinkIntervalMs = 500;
 constexpr UINT kMinMonitorIntervalMs = 500;
+constexpr UINT kSafetyNetMonitorIntervalMs = 30000;
+constexpr DWORD kDirectoryChangeBufferBytes = 16 * 1024;
 constexpr double kMinMonitorIntervalSeconds = static_cast<double>(kMinMonitorIntervalMs) / 1000.0;
 constexpr double kMaxTimerSupportedSeconds = static_cast<double>((std::numeric_limits<UINT>::max)()) / 1000.0;
 constexpr wchar_t kSingleInstanceMutexName[] = L"Local\\BackrestTrayWatcher.Singleton";
@@ -46,12 +72,35 @@ constexpr UINT_PTR kAcknowledgePopupTimerId = 3;
 constexpr UINT kDefaultAcknowledgePopupDurationMs = 2500;
 constexpr UINT kMinAcknowledgePopupDurationMs = 500;
 constexpr UINT kMaxAcknowledgePopupDurationMs = 30000;
+constexpr ULONGLONG kMinMappedScanBytes = 1024 * 1024;
+constexpr ULONGLONG kMappedScanWindowBytes = 256ull * 1024 * 1024;
+constexpr ULONGLONG kLineCheckpointIntervalBytes = 4ull * 1024 * 1024;
+constexpr ULONGLONG kMinParallelScanChunkBytes = 1024 * 1024;
+constexpr DWORD kParallelScanChunksPerWorker = 4;
+constexpr UINT kDefaultScanBudgetMegabytes = 64;
+constexpr UINT kDefaultScanBudgetMs = 0;
+constexpr ULONGLONG kMinTimedScanSliceBytes = 1024 * 1024;
+constexpr size_t kAlertArenaChunkBytes = 1024 * 1024;
+constexpr size_t kDecodedAlertCacheEntries = 256;
+constexpr size_t kAlertAppendJournalEntries = 16;
+constexpr size_t kMaxAlertCandidates = 2000000;
+constexpr ULONGLONG kAlertCandidateReadGapBytes = 4 * 1024;
+constexpr ULONGLONG kAlertCandidateReadBlockBytes = 1024 * 1024;
+constexpr UINT kDefaultMaxResidentAlerts = 10000;
+constexpr UINT kDefaultMaxResidentAlertMegabytes = 64;
+constexpr size_t kSpilledAlertPageRecords = 64;
+constexpr size_t kSpilledAlertPageCacheEntries = 4;
+constexpr UINT kNoIgnoreRule = (std::numeric_limits<UINT>::max)();
+constexpr UINT kNoIgnoreTerm = (std::numeric_limits<UINT>::max)();
+constexpr UINT kNoIgnoreTermState = (std::numeric_limits<UINT>::max)();
+constexpr ULONGLONG kUnterminatedLineFlushMs = 3000;
+constexpr DWORD kLineCheckpointHashWindowBytes = 64;
+constexpr std::string_view kLineIndexFileMagic = "BRWLIDX1";
 constexpr std::string_view kAlertKeyword = "\"logger\":";
-constexpr std::string_view kWarnLevelKeyword = "\"level\":\"warn\"";
-constexpr std::string_view kErrorLevelKeyword = "\"level\":\"error\"";
-constexpr std::string_view kDPanicLevelKeyword = "\"level\":\"dpanic\"";
-constexpr std::string_view kPanicLevelKeyword = "\"level\":\"panic\"";
-constexpr std::string_view kFatalLevelKeyword = "\"level\":\"fatal\"";
+constexpr std::string_view kLevelKeyPrefix = "\"level\":\"";
+constexpr size_t kMaxLevelNameLength = 6;
+constexpr size_t kLevelHashSlots = 16;
+constexpr wchar_t kDefaultMinimumAlertLevel[] = L"warn";
 constexpr int kAcknowledgePopupWidth = 420;
 constexpr int kAcknowledgePopupHeight = 72;
 constexpr int kAcknowledgePopupOffsetPx = 8;
@@ -60,6 +109,8 @@ constexpr wchar_t kAlertManagerWindowClassName[] = L"BackrestWatcherAlertManager
 constexpr wchar_t kDoubleClickActionDialogClassName[] = L"BackrestWatcherDoubleClickActionWindowClass";
 constexpr wchar_t kIgnoreFileName[] = L"Ignore.txt";
 constexpr wchar_t kDebugLogFileName[] = L"debuglog.txt";
+constexpr wchar_t kLineIndexFileName[] = L"backrest_tray_watcher.lineidx";
+constexpr wchar_t kAlertSpillFileName[] = L"backrest_tray_watcher.alerts";
 constexpr int kAlertManagerWindowWidth = 760;
 constexpr int kAlertManagerWindowHeight = 520;
 constexpr int kHiddenOwnerWindowWidth = 360;
@@ -70,14 +121,26 @@ constexpr int kAlertManagerButtonHeight = 28;
 constexpr int kAlertManagerButtonSpacingPx = 8;
 constexpr int kAlertManagerDetailsHeight = 138;
 constexpr std::string_view kIgnoreRuleSeparator = "&&";
+constexpr std::string_view kRegexIgnorePrefix = "re:";
+constexpr std::string_view kGlobIgnorePrefix = "glob:";
+constexpr size_t kMaxIgnorePatternInstructions = 4096;
+constexpr UINT kMaxIgnorePatternRepeat = 256;
+constexpr UINT kUnboundedPatternRepeat = (std::numeric_limits<UINT>::max)();
+constexpr int kMaxIgnorePatternDepth = 32;
 constexpr wchar_t kIgnoreUsageHintText[] =
     L"Ignore.txt usage:\r\n"
     L"- Each line is one rule.\r\n"
     L"- Use && to require all parts.\r\n"
+    L"- A part written as logger=..., msg=..., item=... or error.message=... requires that field "
+    L"to have exactly this value; any other part must appear somewhere in the line.\r\n"
+    L"- re:... searches the line for a regular expression and glob:... matches the whole line against "
+    L"a wildcard pattern (* and ?); write msg=re:... or msg=glob:... to test one field instead.\r\n"
     L"- Example rule:\r\n"
     L"\"level\":\"warn\" && \"msg\":\"error processing item\"\r\n"
     L"This rule will ignore any log line that contains both of the specified parts: "
     L"\"level\":\"warn\" and \"msg\":\"error processing item\".\r\n"
+    L"- [N hits] before a rule counts the lines it ignored since the last rescan; Export rule stats "
+    L"saves the counts and match times of all rules.\r\n"
     L"- After editing Ignore.txt manually, click Refresh list.";
 constexpr UINT kAlertManagerTabMessages = 0;
 constexpr UINT kAlertManagerTabIgnored = 1;
@@ -90,6 +153,7 @@ constexpr int kControlIgnoredAlertsDetails = 2006;
 constexpr int kControlRefreshIgnoredButton = 2007;
 constexpr int kControlOpenIgnoreFileButton = 2008;
 constexpr int kControlIgnoreUsageHint = 2009;
+constexpr int kControlExportIgnoreStatsButton = 2010;
 constexpr int kControlDoubleClickActionCombo = 2101;
 
 enum class AlertSeverity {
@@ -107,23 +171,339 @@ enum class DoubleClickAction : UINT {
   kAcknowledgeAlert = kMenuAcknowledgeAlert,
 };
 
+// Parsed fields an ignore rule part can name, as in "msg=error processing item".
+enum class IgnoreField : UINT {
+  kLogger = 0,
+  kMessage = 1,
+  kItem = 2,
+  kErrorMessage = 3,
+};
+
+constexpr size_t kIgnoreFieldCount = 4;
+
+struct IgnoreFieldName {
+  std::string_view name;
+  IgnoreField field = IgnoreField::kLogger;
+};
+
+constexpr IgnoreFieldName kIgnoreFieldNames[] = {
+    {"logger", IgnoreField::kLogger},
+    {"msg", IgnoreField::kMessage},
+    {"item", IgnoreField::kItem},
+    {"error.message", IgnoreField::kErrorMessage},
+};
+
+// A rule part that requires the decoded value of a field to equal value exactly.
+struct IgnoreFieldTerm {
+  IgnoreField field = IgnoreField::kLogger;
+  std::string value;
+};
+
+enum class PatternOp : unsigned char {
+  kByteSet,
+  kSplit,
+  kAssertBegin,
+  kAssertEnd,
+  kMatch,
+};
+
+struct PatternInstruction {
+  PatternOp op = PatternOp::kMatch;
+  UINT next = 0;
+  UINT alternative = 0;
+  ULONGLONG bytes[4] = {};
+};
+
+// A compiled re: or glob: pattern: a Thompson NFA that IgnorePatternMatches runs one state set at a
+// time, so there is no backtracking. anchoredStart patterns are only tried from the first byte.
+struct IgnorePattern {
+  std::vector<PatternInstruction> program;
+  UINT start = 0;
+  bool anchoredStart = false;
+};
+
+// A rule part written as re:... or glob:..., matched against the whole line or, written as
+// msg=re:..., against one field's decoded value. requiredLiteral is text every match contains in the
+// raw line; it is handed to the automaton so the pattern only runs on lines that have it.
+struct IgnorePatternTerm {
+  bool glob = false;
+  bool fieldScoped = false;
+  IgnoreField field = IgnoreField::kLogger;
+  std::string patternText;
+  std::string requiredLiteral;
+  std::shared_ptr<const IgnorePattern> pattern;
+};
+
+struct IgnoreRule {
+  std::string text;
+  std::vector<std::string> requiredTerms;
+  std::vector<IgnoreFieldTerm> fieldTerms;
+  std::vector<IgnorePatternTerm> patternTerms;
+};
+
+// Aho-Corasick automaton over the distinct substring parts of all ignore rules. Each state keeps its
+// edges sorted by byte in edgeBytes/edgeTargets, except the root, which has a full table; a byte
+// without an edge follows the failure links. outputLink chains the states whose term is a suffix of
+// the current match.
+struct IgnoreTermState {
+  UINT firstEdge = 0;
+  UINT edgeCount = 0;
+  UINT failure = 0;
+  UINT term = kNoIgnoreTerm;
+  UINT outputLink = kNoIgnoreTermState;
+};
+
+struct IgnoreTermAutomaton {
+  std::vector<IgnoreTermState> states;
+  std::vector<unsigned char> edgeBytes;
+  std::vector<UINT> edgeTargets;
+  UINT rootTransitions[256] = {};
+};
+
+// The ignore rules compiled for matching. Substring parts and field parts share one term numbering:
+// the former are found by the automaton, the latter by hashing the line's field values into
+// fieldValueTermIds, whose keys point into rules. termRuleIds[termRuleBegins[t]..termRuleBegins[t + 1])
+// are the rules requiring term t, and ruleTermCounts holds the number of distinct terms of each rule.
+// Pattern parts are not terms; only their required literals are. Rules with pattern parts but no
+// terms at all are listed in patternOnlyRuleIds, as they are candidates for every line.
+// Immutable once built, so the scanner and the alert store share it by pointer.
+struct IgnoreRuleSet {
+  std::vector<IgnoreRule> rules;
+  IgnoreTermAutomaton automaton;
+  std::unordered_map<std::string_view, UINT> fieldValueTermIds[kIgnoreFieldCount];
+  std::vector<UINT> termRuleBegins;
+  std::vector<UINT> termRuleIds;
+  std::vector<UINT> ruleTermCounts;
+  std::vector<UINT> patternOnlyRuleIds;
+};
+
+// QueryPerformanceCounter ticks spent matching ignore rules during one scan. ruleTicks is indexed like
+// IgnoreRuleSet::rules and covers each rule's re: and glob: parts, the only work that belongs to a
+// single rule; the field lookups and the automaton pass are shared and only count toward totalTicks.
+struct IgnoreMatchCost {
+  std::vector<ULONGLONG> ruleTicks;
+  ULONGLONG totalTicks = 0;
+  ULONGLONG lineCount = 0;
+};
+
+// What one ignore rule did since the last full rescan. Kept by rule text on the UI thread, so it
+// survives reloading Ignore.txt until the rescan that follows.
+struct IgnoreRuleStats {
+  ULONGLONG hits = 0;
+  ULONGLONG lastHitLine = 0;
+  ULONGLONG matchTicks = 0;
+};
+
+// Byte range in an alert's raw line; empty when the line has no such field.
+struct AlertFieldSpan {
+  UINT begin = 0;
+  UINT end = 0;
+};
+
+// String value spans keep their quotes; tsMember covers the whole "ts" member.
+struct AlertFieldSpans {
+  AlertFieldSpan logger;
+  AlertFieldSpan message;
+  AlertFieldSpan item;
+  AlertFieldSpan errorMessage;
+  AlertFieldSpan tsMember;
+};
+
+// One detected alert on its way from the scanner to the AlertStore. Only the UTF-8 line and where its
+// fields are is kept; everything shown in the UI is derived from those when it is displayed.
+// matchedIgnoreRuleId indexes the ignore rule snapshot the line was scanned with. Entries with the same
+// fingerprint (the line without its "ts" member, plus the matched rule) are one alert in the AlertStore.
 struct AlertEntry {
   AlertSeverity severity = AlertSeverity::kNone;
   bool isIgnored = false;
   ULONGLONG lineNumber = 0;
+  ULONGLONG lineOffset = 0;
+  UINT matchedIgnoreRuleId = kNoIgnoreRule;
+  ULONGLONG fingerprint = 0;
   std::string rawLine;
-  std::string ignoreRuleText;
-  std::string matchedIgnoreRuleText;
-  std::wstring listText;
-  std::wstring summaryText;
-  std::wstring itemText;
-  std::wstring errorMessageText;
-  std::wstring detailText;
+  AlertFieldSpans fields;
 };
 
-struct IgnoreRule {
-  std::string text;
-  std::vector<std::string> requiredTerms;
+// Read-only view of one alert, whether it is still an AlertEntry or already in the AlertStore.
+// lineNumber is where the alert was first seen and the text is from that line.
+struct AlertView {
+  AlertSeverity severity = AlertSeverity::kNone;
+  bool isIgnored = false;
+  ULONGLONG lineNumber = 0;
+  ULONGLONG lastLineNumber = 0;
+  UINT occurrenceCount = 0;
+  std::string_view rawLine;
+  std::string_view matchedIgnoreRuleText;
+  AlertFieldSpans fields;
+};
+
+struct AlertTextRef {
+  UINT chunk = 0;
+  UINT offset = 0;
+  UINT length = 0;
+};
+
+// Append-only text storage in kAlertArenaChunkBytes chunks (longer texts get a chunk of their own), so
+// storing a line is one copy and never moves the lines stored before it.
+struct AlertTextArena {
+  std::vector<std::unique_ptr<char[]>> chunks;
+  size_t lastChunkUsed = 0;
+  size_t lastChunkCapacity = 0;
+};
+
+// A line re-read from the log for an offsets-only AlertStore.
+struct DecodedAlertLine {
+  ULONGLONG lineOffset = 0;
+  UINT lineLength = 0;
+  ULONGLONG lastUse = 0;
+  std::string rawLine;
+  AlertFieldSpans fields;
+};
+
+// Undoes one AppendAlertToStore, for retracting the entries of an unterminated line.
+struct AlertAppendUndo {
+  UINT alertIndex = 0;
+  bool createdAlert = false;
+  ULONGLONG previousLastLineNumber = 0;
+};
+
+// One alert record in the spill file, in the order WriteBinaryValue writes them; rawLine is empty for
+// an offsets-only store.
+struct SpilledAlert {
+  unsigned char severity = 0;
+  unsigned char activeSeverity = 0;
+  UINT occurrenceCount = 0;
+  ULONGLONG lineNumber = 0;
+  ULONGLONG lastLineNumber = 0;
+  ULONGLONG lineOffset = 0;
+  UINT lineLength = 0;
+  UINT matchedIgnoreRuleId = kNoIgnoreRule;
+  AlertFieldSpans fields;
+  std::string rawLine;
+};
+
+constexpr size_t kSpilledAlertHeaderBytes = 2 * sizeof(unsigned char) + 4 * sizeof(UINT) +
+                                            3 * sizeof(ULONGLONG) + sizeof(AlertFieldSpans);
+
+struct SpilledAlertPage {
+  size_t firstIndex = 0;
+  ULONGLONG lastUse = 0;
+  std::vector<SpilledAlert> alerts;
+};
+
+// The retained alerts, one per fingerprint and one column per attribute; the line columns describe
+// the first occurrence. activeSeverities is kNone for ignored alerts, so the tray severity is the
+// maximum of that one byte array.
+// With offsetsOnly set the line text is not kept at all: rawLines and fields stay empty and a line is
+// re-read from the log when it is displayed, through an LRU cache of kDecodedAlertCacheEntries lines.
+// Past the resident limits the oldest alerts spill to an append-only file. Alert indexes count the
+// spilled ones first, so an index stays valid across a spill; the columns only hold the resident
+// alerts from spilledCount on. Spilled alerts are paged back kSpilledAlertPageRecords at a time.
+struct AlertStore {
+  bool offsetsOnly = false;
+  size_t spilledCount = 0;
+  unsigned char spilledHighestActiveSeverity = 0;
+  ULONGLONG spillFileBytes = 0;
+  std::vector<ULONGLONG> spillPageOffsets;
+  std::vector<SpilledAlertPage> spilledPages;
+  ULONGLONG spilledPageUseCount = 0;
+  ULONGLONG residentTextBytes = 0;
+  std::vector<unsigned char> severities;
+  std::vector<unsigned char> activeSeverities;
+  std::vector<ULONGLONG> fingerprints;
+  std::vector<UINT> occurrenceCounts;
+  std::vector<ULONGLONG> lineNumbers;
+  std::vector<ULONGLONG> lastLineNumbers;
+  std::vector<ULONGLONG> lineOffsets;
+  std::vector<UINT> lineLengths;
+  std::vector<UINT> matchedIgnoreRuleIds;
+  std::unordered_map<ULONGLONG, UINT> alertIndexByFingerprint;
+  std::vector<AlertAppendUndo> appendJournal;
+  UINT longestLineLength = 0;
+  std::shared_ptr<const IgnoreRuleSet> ignoreRules;
+  AlertTextArena arena;
+  std::vector<AlertTextRef> rawLines;
+  std::vector<AlertFieldSpans> fields;
+  HANDLE logFile = INVALID_HANDLE_VALUE;
+  std::vector<DecodedAlertLine> decodedLines;
+  ULONGLONG decodedLineUseCount = 0;
+};
+
+// A member of a JSON object as byte offsets into the tokenized text. key is the raw text between the
+// quotes; the value span includes a string value's quotes, so it can be decoded on demand.
+struct JsonFieldSpan {
+  std::string_view key;
+  size_t memberBegin = 0;
+  size_t valueBegin = 0;
+  size_t valueEnd = 0;
+};
+
+struct JsonLineFields {
+  std::string_view line;
+  std::vector<size_t> structuralPositions;
+  std::vector<JsonFieldSpan> topLevel;
+  std::vector<JsonFieldSpan> error;
+};
+
+// Number of '\n' bytes in [0, offset) of the log, i.e. the line number of the line containing offset
+// minus one when offset is not at a line start.
+// contentHash covers the kLineCheckpointHashWindowBytes before offset and is filled in lazily when
+// the index is saved; checkpoints loaded from disk stay unverified until that hash is re-checked.
+struct LineCheckpoint {
+  ULONGLONG offset = 0;
+  ULONGLONG newlineCount = 0;
+  ULONGLONG contentHash = 0;
+  bool hasContentHash = false;
+  bool verified = true;
+};
+
+struct LogFileIdentity {
+  DWORD volumeSerialNumber = 0;
+  ULONGLONG fileIndex = 0;
+};
+
+// Sorted, roughly kLineCheckpointIntervalBytes apart. Grown as a side effect of scanning so a line
+// number lookup only has to count from the nearest checkpoint instead of from byte 0.
+struct LineCheckpointIndex {
+  std::vector<LineCheckpoint> checkpoints;
+  LogFileIdentity fileIdentity;
+  bool hasFileIdentity = false;
+  bool dirty = false;
+};
+
+enum class ScanCommandKind {
+  kPoll,
+  kRescan,
+  kReclassify,
+  kAcknowledge,
+  kSetLogPath,
+  kShutdown,
+};
+
+struct ScanCommand {
+  ScanCommand* next = nullptr;
+  ScanCommandKind kind = ScanCommandKind::kPoll;
+  std::wstring logPath;
+  std::shared_ptr<const IgnoreRuleSet> ignoreRules;
+};
+
+// What one scanner command changed, applied by the UI thread in the order it was produced.
+struct ScanBatch {
+  ScanBatch* next = nullptr;
+  bool replacesEntries = false;
+  std::vector<AlertEntry> entries;
+  std::shared_ptr<const IgnoreRuleSet> ignoreRules;
+  IgnoreMatchCost ignoreMatchCost;
+  bool reclassified = false;
+  AlertSeverity highestSeverity = AlertSeverity::kNone;
+  bool acknowledgedOffsetChanged = false;
+  ULONGLONG acknowledgedOffset = 0;
+  bool acknowledged = false;
+  size_t retractedEntryCount = 0;
+  bool catchingUp = false;
+  ULONGLONG catchUpStartOffset = 0;
+  ULONGLONG scannedOffset = 0;
+  ULONGLONG targetOffset = 0;
 };
 
 struct AppState {
@@ -131,10 +511,10 @@ struct AppState {
   std::wstring configPath;
   std::wstring ignorePath;
   std::wstring debugLogPath;
+  std::wstring lineIndexPath;
+  std::wstring alertSpillPath;
   std::wstring logPath;
   ULONGLONG acknowledgedOffset = 0;
-  ULONGLONG lastOffset = 0;
-  ULONGLONG lastLineNumber = 0;
   UINT monitorIntervalMs = kDefaultMonitorIntervalMs;
   bool monitorIntervalUseMinutes = false;
   bool debugMode = false;
@@ -158,18 +538,90 @@ struct AppState {
   HWND ignoredAlertsDetailsHwnd = nullptr;
   HWND refreshIgnoredButtonHwnd = nullptr;
   HWND openIgnoreFileButtonHwnd = nullptr;
+  HWND exportIgnoreStatsButtonHwnd = nullptr;
   HWND ignoreUsageHintHwnd = nullptr;
   HANDLE singleInstanceMutex = nullptr;
   UINT taskbarCreatedMessage = 0;
   std::vector<IgnoreRule> ignoredRules;
+  std::shared_ptr<const IgnoreRuleSet> ignoreRuleSet;
+  std::unordered_map<std::string, IgnoreRuleStats> ignoreRuleStats;
+  ULONGLONG ignoreMatchTicks = 0;
+  ULONGLONG ignoreMatchLineCount = 0;
   bool ignoreListStateKnown = false;
   bool ignoreFileExists = false;
   std::filesystem::file_time_type ignoreFileLastWriteTime = {};
-  std::vector<AlertEntry> activeAlertEntries;
+  AlertStore activeAlerts;
+  UINT maxResidentAlerts = kDefaultMaxResidentAlerts;
+  ULONGLONG maxResidentAlertBytes = static_cast<ULONGLONG>(kDefaultMaxResidentAlertMegabytes) * 1024 * 1024;
+  ULONGLONG scanBudgetBytes = 0;
+  UINT scanBudgetMs = 0;
+  AlertSeverity minimumAlertSeverity = AlertSeverity::kWarning;
+  bool scanCatchingUp = false;
+  UINT scanProgressPercent = 0;
+  HANDLE scannerThread = nullptr;
+  HANDLE scannerWakeEvent = nullptr;
+  std::atomic<ScanCommand*> scanCommands{nullptr};
+  std::atomic<ScanBatch*> scanBatches{nullptr};
+  HANDLE logChangeNotifierThread = nullptr;
+  HANDLE logChangeNotifierStopEvent = nullptr;
+  ULONGLONG logChangeNotifierLastStartTick = 0;
+  std::atomic<bool> logChangePending{false};
 };
 
 AppState g_state;
 
+// A trailing line without its '\n' yet, as tracked by ScannerState::pendingTail.
+struct UnterminatedTail {
+  ULONGLONG endOffset = 0;
+  ULONGLONG firstSeenTick = 0;
+  bool flushed = false;
+  size_t flushedEntryCount = 0;
+};
+
+// The line behind one scanned alert entry. Enough to read the line back and to know which rule it
+// matched, so a rule change can reclassify the entries without scanning the log again.
+struct AlertCandidate {
+  ULONGLONG lineOffset = 0;
+  ULONGLONG lineNumber = 0;
+  UINT lineLength = 0;
+  UINT matchedIgnoreRuleId = kNoIgnoreRule;
+};
+
+// The log cursor. Owned by the scanner thread once it runs; the UI thread reaches it only through
+// ScanCommand. ignoreRules is an immutable snapshot, so scan workers may read it concurrently.
+// lastOffset only ever advances to a line start, so resuming needs no carried-over bytes: a line still
+// being written is re-read once it is finished. pendingTail tracks such an unterminated tail; if it
+// stops growing for kUnterminatedLineFlushMs it is classified as is, and the entries that produced are
+// retracted again should the line be continued after all. alertCandidates follows the entries posted
+// since the last replacing batch, in the order the store receives them; past maxAlertCandidates it is
+// dropped and a rule change rescans the log instead.
+struct ScannerState {
+  std::wstring logPath;
+  ULONGLONG acknowledgedOffset = 0;
+  ULONGLONG scanBudgetBytes = 0;
+  UINT scanBudgetMs = 0;
+  double scanBytesPerMs = 0.0;
+  ULONGLONG lastOffset = 0;
+  ULONGLONG lastLineNumber = 0;
+  bool catchingUp = false;
+  ULONGLONG catchUpStartOffset = 0;
+  ULONGLONG catchUpTargetOffset = 0;
+  UnterminatedTail pendingTail;
+  AlertSeverity minimumAlertSeverity = AlertSeverity::kWarning;
+  LineCheckpointIndex lineCheckpoints;
+  HANDLE logFile = INVALID_HANDLE_VALUE;
+  ULONGLONG logFileGeneration = 0;
+  LogFileIdentity logFileIdentity;
+  ULONGLONG lastOffsetTailHash = 0;
+  bool hasLastOffsetTailHash = false;
+  std::shared_ptr<const IgnoreRuleSet> ignoreRules;
+  std::vector<AlertCandidate> alertCandidates;
+  size_t maxAlertCandidates = kMaxAlertCandidates;
+  bool alertCandidatesOverflowed = false;
+};
+
+ScannerState g_scanner;
+
 struct IntervalInputDialogState {
   UINT initialValueMs = 0;
   bool initialUseMinutes = false;
@@ -201,7 +653,13 @@ bool TryBuildAlertEntryFromLine(std::string_view line, AlertEntry* outEntry);
 bool ReloadIgnoreListIfChanged(bool forceReload);
 void OpenLogFile();
 AlertSeverity MaxAlertSeverity(AlertSeverity left, AlertSeverity right);
-const IgnoreRule* FindMatchingIgnoreRule(std::string_view rawLine);
+void AppendUtf8AsWide(std::string_view text, std::wstring* out);
+const IgnoreRule* FindMatchingIgnoreRule(
+    const IgnoreRuleSet& ruleSet,
+    std::string_view rawLine,
+    const AlertFieldSpans& fields,
+    IgnoreMatchCost* cost);
+void BuildJsonStructuralIndex(std::string_view json, std::vector<size_t>* outPositions);
 
 std::wstring ExeDirectory() {
   wchar_t path[MAX_PATH] = {};
@@ -230,6 +688,14 @@ std::wstring DebugLogPath() {
   return ExeDirectory() + L"\\" + kDebugLogFileName;
 }
 
+std::wstring LineIndexFilePath() {
+  return ExeDirectory() + L"\\" + kLineIndexFileName;
+}
+
+std::wstring AlertSpillFilePath() {
+  return ExeDirectory() + L"\\" + kAlertSpillFileName;
+}
+
 std::string WideToUtf8(std::wstring_view text) {
   if (text.empty()) {
     return {};
@@ -337,6 +803,10 @@ std::wstring WindowMessageName(UINT message) {
       return L"WM_NULL";
     case kTrayMessage:
       return L"kTrayMessage";
+    case kLogChangedMessage:
+      return L"kLogChangedMessage";
+    case kScanResultsMessage:
+      return L"kScanResultsMessage";
     default:
       return L"MSG_" + std::to_wstring(message);
   }
@@ -367,13 +837,17 @@ void DebugLog(std::wstring_view message) {
   line.append(message);
   line.append(L"\r\n");
 
+  const std::string utf8 = WideToUtf8(line);
+
+  // Scan workers log too; keep their lines whole.
+  static SRWLOCK debugLogLock = SRWLOCK_INIT;
+  AcquireSRWLockExclusive(&debugLogLock);
   std::ofstream outputFile(std::filesystem::path(g_state.debugLogPath), std::ios::binary | std::ios::app);
-  if (!outputFile.is_open()) {
-    return;
+  if (outputFile.is_open()) {
+    outputFile.write(utf8.data(), static_cast<std::streamsize>(utf8.size()));
   }
-
-  const std::string utf8 = WideToUtf8(line);
-  outputFile.write(utf8.data(), static_cast<std::streamsize>(utf8.size()));
+  outputFile.close();
+  ReleaseSRWLockExclusive(&debugLogLock);
 }
 
 void DebugLogWindowMessage(std::wstring_view windowName, UINT message, WPARAM wParam, LPARAM lParam) {
@@ -539,34 +1013,8 @@ constexpr DoubleClickAction kDoubleClickActionOptions[] = {
 };
 
 std::wstring Utf8ToWide(std::string_view text) {
-  if (text.empty()) {
-    return {};
-  }
-
-  const int requiredChars = MultiByteToWideChar(
-      CP_UTF8,
-      0,
-      text.data(),
-      static_cast<int>(text.size()),
-      nullptr,
-      0);
-  if (requiredChars <= 0) {
-    std::wstring fallback;
-    fallback.reserve(text.size());
-    for (const unsigned char ch : text) {
-      fallback.push_back(static_cast<wchar_t>(ch));
-    }
-    return fallback;
-  }
-
-  std::wstring wide(requiredChars, L'\0');
-  MultiByteToWideChar(
-      CP_UTF8,
-      0,
-      text.data(),
-      static_cast<int>(text.size()),
-      wide.data(),
-      requiredChars);
+  std::wstring wide;
+  AppendUtf8AsWide(text, &wide);
   return wide;
 }
 
@@ -624,26 +1072,43 @@ bool ParseHexDigit(char ch, unsigned int* outValue) {
   return false;
 }
 
+// *outValue points into text when the literal has no escapes, which is nearly always; otherwise the
+// literal is decoded into *scratch and *outValue points there.
 bool ParseJsonStringLiteral(
     std::string_view text,
     size_t openingQuotePos,
     size_t* outNextPos,
-    std::string* outValue) {
-  if (!outValue || openingQuotePos >= text.size() || text[openingQuotePos] != '"') {
+    std::string* scratch,
+    std::string_view* outValue) {
+  if (!scratch || !outValue || openingQuotePos >= text.size() || text[openingQuotePos] != '"') {
+    return false;
+  }
+
+  const size_t valueBegin = openingQuotePos + 1;
+  const size_t specialPos = text.find_first_of("\\\"", valueBegin);
+  if (specialPos == std::string_view::npos) {
     return false;
   }
+  if (text[specialPos] == '"') {
+    if (outNextPos) {
+      *outNextPos = specialPos + 1;
+    }
+    *outValue = text.substr(valueBegin, specialPos - valueBegin);
+    return true;
+  }
 
-  outValue->clear();
-  for (size_t pos = openingQuotePos + 1; pos < text.size(); ++pos) {
+  scratch->assign(text.substr(valueBegin, specialPos - valueBegin));
+  for (size_t pos = specialPos; pos < text.size(); ++pos) {
     const char ch = text[pos];
     if (ch == '"') {
       if (outNextPos) {
         *outNextPos = pos + 1;
       }
+      *outValue = *scratch;
       return true;
     }
     if (ch != '\\') {
-      outValue->push_back(ch);
+      scratch->push_back(ch);
       continue;
     }
 
@@ -657,22 +1122,22 @@ bool ParseJsonStringLiteral(
       case '"':
       case '\\':
       case '/':
-        outValue->push_back(escaped);
+        scratch->push_back(escaped);
         break;
       case 'b':
-        outValue->push_back('\b');
+        scratch->push_back('\b');
         break;
       case 'f':
-        outValue->push_back('\f');
+        scratch->push_back('\f');
         break;
       case 'n':
-        outValue->push_back('\n');
+        scratch->push_back('\n');
         break;
       case 'r':
-        outValue->push_back('\r');
+        scratch->push_back('\r');
         break;
       case 't':
-        outValue->push_back('\t');
+        scratch->push_back('\t');
         break;
       case 'u': {
         if (pos + 4 >= text.size()) {
@@ -686,12 +1151,12 @@ bool ParseJsonStringLiteral(
           }
           codePoint = (codePoint << 4) | nibble;
         }
-        AppendUtf8CodePoint(codePoint, outValue);
+        AppendUtf8CodePoint(codePoint, scratch);
         pos += 4;
         break;
       }
       default:
-        outValue->push_back(escaped);
+        scratch->push_back(escaped);
         break;
     }
   }
@@ -699,147 +1164,162 @@ bool ParseJsonStringLiteral(
   return false;
 }
 
-bool ExtractJsonStringField(std::string_view json, std::string_view fieldName, std::string* outValue) {
-  if (!outValue || fieldName.empty()) {
-    return false;
+size_t SkipJsonWhitespace(std::string_view json, size_t pos) {
+  while (pos < json.size() && std::isspace(static_cast<unsigned char>(json[pos])) != 0) {
+    ++pos;
   }
+  return pos;
+}
 
-  const std::string pattern = "\"" + std::string(fieldName) + "\"";
-  size_t searchPos = 0;
-  while (searchPos < json.size()) {
-    const size_t fieldPos = json.find(pattern, searchPos);
-    if (fieldPos == std::string_view::npos) {
-      return false;
-    }
-
-    size_t valuePos = fieldPos + pattern.size();
-    while (valuePos < json.size() && std::isspace(static_cast<unsigned char>(json[valuePos])) != 0) {
-      ++valuePos;
-    }
-    if (valuePos >= json.size() || json[valuePos] != ':') {
-      searchPos = fieldPos + pattern.size();
-      continue;
-    }
-
-    ++valuePos;
-    while (valuePos < json.size() && std::isspace(static_cast<unsigned char>(json[valuePos])) != 0) {
-      ++valuePos;
-    }
-    if (valuePos >= json.size() || json[valuePos] != '"') {
-      searchPos = fieldPos + pattern.size();
-      continue;
-    }
+// Walks the structural index of a JSON text. Strings contain no structural positions, so the position
+// after an opening quote is always its closing quote.
+struct JsonIndexCursor {
+  std::string_view json;
+  const std::vector<size_t>* positions = nullptr;
+  size_t next = 0;
+};
 
-    return ParseJsonStringLiteral(json, valuePos, nullptr, outValue);
+bool TakeJsonStructural(JsonIndexCursor* cursor, size_t* outPos) {
+  if (cursor->next >= cursor->positions->size()) {
+    return false;
   }
-
-  return false;
+  *outPos = (*cursor->positions)[cursor->next++];
+  return true;
 }
 
-bool ExtractErrorMessageField(std::string_view line, std::string* outValue) {
-  if (!outValue) {
-    return false;
+// End of the value starting at valueBegin, consuming its structural positions. Objects and arrays are
+// skipped by bracket depth; a truncated one ends at the end of the text. Scalars end before the next
+// separator, without trailing whitespace. Returns npos for an unterminated string.
+size_t SkipJsonValue(JsonIndexCursor* cursor, size_t valueBegin) {
+  const std::string_view json = cursor->json;
+  const char first = json[valueBegin];
+  size_t pos = 0;
+  if (first == '"') {
+    if (!TakeJsonStructural(cursor, &pos) || !TakeJsonStructural(cursor, &pos)) {
+      return std::string_view::npos;
+    }
+    return pos + 1;
+  }
+  if (first == '{' || first == '[') {
+    int depth = 0;
+    while (TakeJsonStructural(cursor, &pos)) {
+      const char ch = json[pos];
+      if (ch == '{' || ch == '[') {
+        ++depth;
+      } else if ((ch == '}' || ch == ']') && --depth == 0) {
+        return pos + 1;
+      }
+    }
+    return json.size();
   }
 
-  const size_t errorFieldPos = line.find("\"error\"");
-  if (errorFieldPos == std::string_view::npos) {
-    return false;
+  size_t valueEnd = cursor->next < cursor->positions->size() ? (*cursor->positions)[cursor->next] : json.size();
+  while (valueEnd > valueBegin && std::isspace(static_cast<unsigned char>(json[valueEnd - 1])) != 0) {
+    --valueEnd;
   }
-  return ExtractJsonStringField(line.substr(errorFieldPos), "message", outValue);
+  return valueEnd;
 }
 
-bool TryFindJsonFieldRange(
-    std::string_view json,
-    std::string_view fieldName,
-    size_t* outFieldPos,
-    size_t* outFieldEnd) {
-  if (!outFieldPos || !outFieldEnd || fieldName.empty()) {
-    return false;
-  }
-
-  const std::string pattern = "\"" + std::string(fieldName) + "\"";
-  size_t searchPos = 0;
-  while (searchPos < json.size()) {
-    const size_t fieldPos = json.find(pattern, searchPos);
-    if (fieldPos == std::string_view::npos) {
-      return false;
+// Records the members of the object whose '{' the cursor has just consumed, in order. The value of the
+// member named nestedKey is tokenized into *outNestedFields on the way instead of being skipped, if it
+// is an object. Malformed or truncated input ends the walk; the members recorded before that point stay
+// usable. Returns the position just past the closing brace, or npos when the object did not close.
+size_t TokenizeJsonObject(
+    JsonIndexCursor* cursor,
+    std::vector<JsonFieldSpan>* outFields,
+    std::string_view nestedKey,
+    std::vector<JsonFieldSpan>* outNestedFields) {
+  const std::string_view json = cursor->json;
+  size_t pos = 0;
+  if (!TakeJsonStructural(cursor, &pos)) {
+    return std::string_view::npos;
+  }
+  if (json[pos] == '}') {
+    return pos + 1;
+  }
+
+  while (json[pos] == '"') {
+    JsonFieldSpan field = {};
+    field.memberBegin = pos;
+    size_t keyEnd = 0;
+    size_t colonPos = 0;
+    if (!TakeJsonStructural(cursor, &keyEnd) || !TakeJsonStructural(cursor, &colonPos) || json[colonPos] != ':') {
+      break;
     }
-
-    size_t valuePos = fieldPos + pattern.size();
-    while (valuePos < json.size() && std::isspace(static_cast<unsigned char>(json[valuePos])) != 0) {
-      ++valuePos;
+    field.key = json.substr(pos + 1, keyEnd - pos - 1);
+    field.valueBegin = SkipJsonWhitespace(json, colonPos + 1);
+    if (field.valueBegin >= json.size()) {
+      break;
     }
-    if (valuePos >= json.size() || json[valuePos] != ':') {
-      searchPos = fieldPos + pattern.size();
-      continue;
+
+    if (outNestedFields && json[field.valueBegin] == '{' && field.key == nestedKey) {
+      TakeJsonStructural(cursor, &pos);
+      field.valueEnd = TokenizeJsonObject(cursor, outNestedFields, {}, nullptr);
+      if (field.valueEnd == std::string_view::npos) {
+        field.valueEnd = json.size();
+        outFields->push_back(field);
+        break;
+      }
+    } else {
+      field.valueEnd = SkipJsonValue(cursor, field.valueBegin);
+      if (field.valueEnd == std::string_view::npos) {
+        break;
+      }
     }
+    outFields->push_back(field);
 
-    ++valuePos;
-    while (valuePos < json.size() && std::isspace(static_cast<unsigned char>(json[valuePos])) != 0) {
-      ++valuePos;
+    if (!TakeJsonStructural(cursor, &pos)) {
+      break;
     }
-    if (valuePos >= json.size()) {
-      return false;
+    if (json[pos] == '}') {
+      return pos + 1;
     }
+    if (json[pos] != ',' || !TakeJsonStructural(cursor, &pos)) {
+      break;
+    }
+  }
+  return std::string_view::npos;
+}
 
-    size_t fieldEnd = valuePos;
-    if (json[valuePos] == '"') {
-      std::string ignoredValue;
-      if (!ParseJsonStringLiteral(json, valuePos, &fieldEnd, &ignoredValue)) {
-        return false;
-      }
-    } else if (json[valuePos] == '{' || json[valuePos] == '[') {
-      const char opening = json[valuePos];
-      const char closing = (opening == '{') ? '}' : ']';
-      int depth = 0;
-      bool inString = false;
-      bool escaping = false;
-      for (fieldEnd = valuePos; fieldEnd < json.size(); ++fieldEnd) {
-        const char ch = json[fieldEnd];
-        if (inString) {
-          if (escaping) {
-            escaping = false;
-          } else if (ch == '\\') {
-            escaping = true;
-          } else if (ch == '"') {
-            inString = false;
-          }
-          continue;
-        }
-
-        if (ch == '"') {
-          inString = true;
-          continue;
-        }
-        if (ch == opening) {
-          ++depth;
-        } else if (ch == closing) {
-          --depth;
-          if (depth == 0) {
-            ++fieldEnd;
-            break;
-          }
-        }
-      }
-      if (fieldEnd > json.size()) {
-        fieldEnd = json.size();
-      }
-    } else {
-      while (fieldEnd < json.size() && json[fieldEnd] != ',' && json[fieldEnd] != '}' && json[fieldEnd] != ']') {
-        ++fieldEnd;
-      }
-      while (fieldEnd > valuePos &&
-             std::isspace(static_cast<unsigned char>(json[fieldEnd - 1])) != 0) {
-        --fieldEnd;
-      }
+// One pass over a log line: the structural index is built first, then the top-level members plus the
+// members of a nested "error" object (where error.message lives) are read off it. Every field lookup
+// afterwards is served from these spans.
+void TokenizeJsonLogLine(std::string_view line, JsonLineFields* outFields) {
+  outFields->line = line;
+  outFields->topLevel.clear();
+  outFields->error.clear();
+  BuildJsonStructuralIndex(line, &outFields->structuralPositions);
+
+  JsonIndexCursor cursor = {};
+  cursor.json = line;
+  cursor.positions = &outFields->structuralPositions;
+  size_t pos = 0;
+  while (TakeJsonStructural(&cursor, &pos)) {
+    if (line[pos] == '{') {
+      TokenizeJsonObject(&cursor, &outFields->topLevel, "error", &outFields->error);
+      break;
     }
+  }
+}
 
-    *outFieldPos = fieldPos;
-    *outFieldEnd = fieldEnd;
-    return true;
+const JsonFieldSpan* FindJsonField(const std::vector<JsonFieldSpan>& fields, std::string_view key) {
+  for (const JsonFieldSpan& field : fields) {
+    if (field.key == key) {
+      return &field;
+    }
   }
+  return nullptr;
+}
 
-  return false;
+bool JsonStringFieldValue(
+    std::string_view json,
+    const JsonFieldSpan* field,
+    std::string* scratch,
+    std::string_view* outValue) {
+  if (!field || json[field->valueBegin] != '"') {
+    return false;
+  }
+  return ParseJsonStringLiteral(json.substr(0, field->valueEnd), field->valueBegin, nullptr, scratch, outValue);
 }
 
 std::wstring FormatAlertSummaryText(
@@ -866,238 +1346,2295 @@ std::wstring FormatAlertSummaryText(
   return summary;
 }
 
-std::wstring FormatAlertListText(bool isIgnored, std::wstring_view rawLineText) {
-  if (!isIgnored) {
-    return std::wstring(rawLineText);
+// The decoded value of the field at span in line; it points into line unless the value had escapes,
+// in which case it lives in *scratch.
+std::string_view AlertFieldValue(std::string_view line, AlertFieldSpan span, std::string* scratch) {
+  std::string_view value;
+  if (span.end > span.begin) {
+    JsonFieldSpan field = {};
+    field.valueBegin = span.begin;
+    field.valueEnd = span.end;
+    JsonStringFieldValue(line, &field, scratch, &value);
+  }
+  return value;
+}
+
+std::string_view AlertFieldText(const AlertView& alert, AlertFieldSpan span, std::string* scratch) {
+  return AlertFieldValue(alert.rawLine, span, scratch);
+}
+
+AlertFieldSpan IgnoreFieldSpan(const AlertFieldSpans& fields, IgnoreField field) {
+  switch (field) {
+    case IgnoreField::kLogger:
+      return fields.logger;
+    case IgnoreField::kMessage:
+      return fields.message;
+    case IgnoreField::kItem:
+      return fields.item;
+    case IgnoreField::kErrorMessage:
+      return fields.errorMessage;
+  }
+  return {};
+}
+
+// The trimmed text before and after the line's "ts" member; the whole line is left when it has none.
+void SplitAlertLineAroundTs(const AlertView& alert, std::string_view* outLeft, std::string_view* outRight) {
+  const std::string_view line = alert.rawLine;
+  const AlertFieldSpan tsMember = alert.fields.tsMember;
+  if (tsMember.end == tsMember.begin) {
+    *outLeft = TrimAsciiWhitespace(line);
+    *outRight = {};
+    return;
+  }
+  *outLeft = TrimAsciiWhitespace(line.substr(0, tsMember.begin));
+  *outRight = TrimAsciiWhitespace(line.substr(tsMember.end));
+}
+
+// A field value can be written as a rule part unless trimming, the part separator or a line break
+// would change it, or a re: or glob: prefix would turn it into a pattern.
+bool IsWritableIgnoreFieldValue(std::string_view value) {
+  return value == TrimAsciiWhitespace(value) && value.find(kIgnoreRuleSeparator) == std::string_view::npos &&
+         value.find_first_of("\r\n") == std::string_view::npos &&
+         value.substr(0, kRegexIgnorePrefix.size()) != kRegexIgnorePrefix &&
+         value.substr(0, kGlobIgnorePrefix.size()) != kGlobIgnorePrefix;
+}
+
+// Exact-value parts for the alert's logger, msg, item and error.message, which the matcher looks up by
+// hash. Alerts without a logger or msg, or with a value that cannot be written, get the line without
+// its ts member instead.
+std::string BuildSuggestedIgnoreRuleText(const AlertView& alert) {
+  std::string fieldRuleText;
+  bool hasIdentifyingField = false;
+  std::string scratch;
+  for (const IgnoreFieldName& fieldName : kIgnoreFieldNames) {
+    const std::string_view value = AlertFieldText(alert, IgnoreFieldSpan(alert.fields, fieldName.field), &scratch);
+    if (value.empty()) {
+      continue;
+    }
+    if (!IsWritableIgnoreFieldValue(value)) {
+      hasIdentifyingField = false;
+      break;
+    }
+    if (!fieldRuleText.empty()) {
+      fieldRuleText += " && ";
+    }
+    fieldRuleText += fieldName.name;
+    fieldRuleText += '=';
+    fieldRuleText += value;
+    hasIdentifyingField = hasIdentifyingField || fieldName.field == IgnoreField::kLogger ||
+                          fieldName.field == IgnoreField::kMessage;
+  }
+  if (hasIdentifyingField) {
+    return fieldRuleText;
+  }
+
+  std::string_view left;
+  std::string_view right;
+  SplitAlertLineAroundTs(alert, &left, &right);
+  if (left.empty()) {
+    return std::string(right);
+  }
+  if (right.empty()) {
+    return std::string(left);
   }
 
-  std::wstring listText = L"(Ignored) ";
-  listText += rawLineText;
+  return std::string(left) + " && " + std::string(right);
+}
+
+std::wstring AlertSummaryText(const AlertView& alert) {
+  std::string loggerScratch;
+  std::string messageScratch;
+  const std::string_view loggerText = AlertFieldText(alert, alert.fields.logger, &loggerScratch);
+  const std::string_view messageText = AlertFieldText(alert, alert.fields.message, &messageScratch);
+  return FormatAlertSummaryText(
+      alert.severity,
+      Utf8ToWide(loggerText),
+      Utf8ToWide(messageText),
+      (loggerText.empty() && messageText.empty()) ? Utf8ToWide(alert.rawLine) : std::wstring());
+}
+
+std::wstring FormatAlertListText(const AlertView& alert) {
+  std::wstring listText = alert.isIgnored ? L"(Ignored) " : L"";
+  if (alert.occurrenceCount > 1) {
+    listText += L"[" + std::to_wstring(alert.occurrenceCount) + L"x] ";
+  }
+  AppendUtf8AsWide(alert.rawLine, &listText);
   return listText;
 }
 
-std::wstring FormatAlertDetailText(const AlertEntry& entry) {
+std::wstring FormatAlertDetailText(const AlertView& alert) {
   std::wstring details = L"Line: ";
-  details += std::to_wstring(entry.lineNumber);
+  details += std::to_wstring(alert.lineNumber);
+  if (alert.occurrenceCount > 1) {
+    details += L"\r\nOccurrences: ";
+    details += std::to_wstring(alert.occurrenceCount);
+    details += L" (last on line ";
+    details += std::to_wstring(alert.lastLineNumber);
+    details += L")";
+  }
   details += L"\r\nStatus: ";
-  details += entry.isIgnored ? L"Ignored" : L"Active";
+  details += alert.isIgnored ? L"Ignored" : L"Active";
   details += L"\r\nSummary: ";
-  details += entry.summaryText;
-  if (!entry.matchedIgnoreRuleText.empty()) {
+  details += AlertSummaryText(alert);
+  if (!alert.matchedIgnoreRuleText.empty()) {
     details += L"\r\nMatched ignore rule: ";
-    details += Utf8ToWide(entry.matchedIgnoreRuleText);
+    AppendUtf8AsWide(alert.matchedIgnoreRuleText, &details);
   }
-  if (!entry.ignoreRuleText.empty()) {
+  const std::string ignoreRuleText = BuildSuggestedIgnoreRuleText(alert);
+  if (!ignoreRuleText.empty()) {
     details += L"\r\nSuggested ignore rule: ";
-    details += Utf8ToWide(entry.ignoreRuleText);
+    AppendUtf8AsWide(ignoreRuleText, &details);
   }
-  if (!entry.itemText.empty()) {
+  std::string fieldScratch;
+  const std::string_view itemText = AlertFieldText(alert, alert.fields.item, &fieldScratch);
+  if (!itemText.empty()) {
     details += L"\r\nItem: ";
-    details += entry.itemText;
+    AppendUtf8AsWide(itemText, &details);
   }
-  if (!entry.errorMessageText.empty()) {
+  const std::string_view errorMessageText = AlertFieldText(alert, alert.fields.errorMessage, &fieldScratch);
+  if (!errorMessageText.empty()) {
     details += L"\r\nError: ";
-    details += entry.errorMessageText;
+    AppendUtf8AsWide(errorMessageText, &details);
   }
   details += L"\r\nRaw:\r\n";
-  details += Utf8ToWide(entry.rawLine);
-  if (entry.isIgnored) {
+  AppendUtf8AsWide(alert.rawLine, &details);
+  if (alert.isIgnored) {
     details += L"\r\n\r\nIgnored messages still appear here, but they do not affect the tray icon severity.";
   }
   return details;
 }
 
-void UpdateAlertEntryPresentation(AlertEntry* entry) {
-  if (!entry) {
-    return;
+// Without the matched rule text, which only the AlertStore holding the rule snapshot can resolve.
+AlertView ViewOfAlertEntry(const AlertEntry& entry) {
+  AlertView alert = {};
+  alert.severity = entry.severity;
+  alert.isIgnored = entry.isIgnored;
+  alert.lineNumber = entry.lineNumber;
+  alert.lastLineNumber = entry.lineNumber;
+  alert.occurrenceCount = 1;
+  alert.rawLine = entry.rawLine;
+  alert.fields = entry.fields;
+  return alert;
+}
+
+std::string_view AlertArenaText(const AlertTextArena& arena, AlertTextRef ref) {
+  if (ref.length == 0) {
+    return {};
   }
+  return std::string_view(arena.chunks[ref.chunk].get() + ref.offset, ref.length);
+}
 
-  const std::wstring rawLineText = Utf8ToWide(entry->rawLine);
-  entry->listText = FormatAlertListText(entry->isIgnored, rawLineText);
-  entry->detailText = FormatAlertDetailText(*entry);
+AlertTextRef AppendAlertArenaText(AlertTextArena* arena, std::string_view text) {
+  AlertTextRef ref = {};
+  if (text.empty()) {
+    return ref;
+  }
+  if (arena->chunks.empty() || arena->lastChunkCapacity - arena->lastChunkUsed < text.size()) {
+    arena->lastChunkCapacity = (std::max)(kAlertArenaChunkBytes, text.size());
+    arena->chunks.push_back(std::make_unique<char[]>(arena->lastChunkCapacity));
+    arena->lastChunkUsed = 0;
+  }
+  ref.chunk = static_cast<UINT>(arena->chunks.size() - 1);
+  ref.offset = static_cast<UINT>(arena->lastChunkUsed);
+  ref.length = static_cast<UINT>(text.size());
+  std::copy(text.begin(), text.end(), arena->chunks.back().get() + arena->lastChunkUsed);
+  arena->lastChunkUsed += text.size();
+  return ref;
 }
 
-ULONGLONG CountLogicalLinesUpToOffset(HANDLE file, ULONGLONG endOffset) {
-  if (file == INVALID_HANDLE_VALUE || endOffset == 0) {
-    return 0;
-  }
+template <typename T>
+void WriteBinaryValue(std::ofstream& outputFile, const T& value) {
+  outputFile.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
 
-  LARGE_INTEGER filePointer = {};
-  filePointer.QuadPart = 0;
-  if (!SetFilePointerEx(file, filePointer, nullptr, FILE_BEGIN)) {
-    return 0;
-  }
+template <typename T>
+bool ReadBinaryValue(std::ifstream& inputFile, T* outValue) {
+  return static_cast<bool>(inputFile.read(reinterpret_cast<char*>(outValue), sizeof(*outValue)));
+}
 
-  constexpr DWORD kBufferSize = 64 * 1024;
-  char buffer[kBufferSize];
-  ULONGLONG remaining = endOffset;
-  ULONGLONG lineCount = 0;
-  bool sawAnyByte = false;
-  char lastByte = '\n';
-  while (remaining > 0) {
-    const DWORD toRead = static_cast<DWORD>(
-        std::min<ULONGLONG>(remaining, static_cast<ULONGLONG>(kBufferSize)));
-    DWORD bytesRead = 0;
-    if (!ReadFile(file, buffer, toRead, &bytesRead, nullptr) || bytesRead == 0) {
-      break;
+size_t AlertCount(const AlertStore& store) {
+  return store.spilledCount + store.severities.size();
+}
+
+bool ReadAlertLineFromLog(AlertStore* store, ULONGLONG lineOffset, UINT lineLength, std::string* outLine) {
+  if (store->logFile == INVALID_HANDLE_VALUE) {
+    store->logFile = CreateFileW(
+        g_state.logPath.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+    if (store->logFile == INVALID_HANDLE_VALUE) {
+      return false;
     }
+  }
 
-    sawAnyByte = true;
-    lineCount += static_cast<ULONGLONG>(std::count(buffer, buffer + bytesRead, '\n'));
-    lastByte = buffer[bytesRead - 1];
-    remaining -= bytesRead;
+  LARGE_INTEGER filePointer = {};
+  filePointer.QuadPart = static_cast<LONGLONG>(lineOffset);
+  if (!SetFilePointerEx(store->logFile, filePointer, nullptr, FILE_BEGIN)) {
+    return false;
   }
 
-  if (sawAnyByte && lastByte != '\n') {
-    ++lineCount;
+  outLine->resize(lineLength);
+  DWORD totalRead = 0;
+  while (totalRead < lineLength) {
+    DWORD bytesRead = 0;
+    if (!ReadFile(store->logFile, outLine->data() + totalRead, lineLength - totalRead, &bytesRead, nullptr) ||
+        bytesRead == 0) {
+      return false;
+    }
+    totalRead += bytesRead;
   }
-  return lineCount;
+  return true;
 }
 
-bool DoesOffsetStartOnNewLine(HANDLE file, ULONGLONG offset) {
-  if (file == INVALID_HANDLE_VALUE || offset == 0) {
-    return true;
+// The returned line stays valid until the next lookup may evict it.
+const DecodedAlertLine& DecodeAlertLineAt(AlertStore* store, ULONGLONG lineOffset, UINT lineLength) {
+  ++store->decodedLineUseCount;
+  DecodedAlertLine* slot = nullptr;
+  for (DecodedAlertLine& decoded : store->decodedLines) {
+    if (decoded.lineOffset == lineOffset && decoded.lineLength == lineLength) {
+      decoded.lastUse = store->decodedLineUseCount;
+      return decoded;
+    }
+    if (!slot || decoded.lastUse < slot->lastUse) {
+      slot = &decoded;
+    }
   }
-
-  LARGE_INTEGER filePointer = {};
-  filePointer.QuadPart = static_cast<LONGLONG>(offset - 1);
-  if (!SetFilePointerEx(file, filePointer, nullptr, FILE_BEGIN)) {
-    return true;
+  if (store->decodedLines.size() < kDecodedAlertCacheEntries) {
+    store->decodedLines.emplace_back();
+    slot = &store->decodedLines.back();
   }
 
-  char previousByte = '\n';
-  DWORD bytesRead = 0;
-  if (!ReadFile(file, &previousByte, 1, &bytesRead, nullptr) || bytesRead != 1) {
-    return true;
+  *slot = DecodedAlertLine{};
+  slot->lastUse = store->decodedLineUseCount;
+  std::string line;
+  if (!ReadAlertLineFromLog(store, lineOffset, lineLength, &line)) {
+    // Left with a length no stored line has, so the next lookup tries the file again.
+    DebugLog(L"Could not re-read alert line at offset " + std::to_wstring(lineOffset) + L" from the log.");
+    return *slot;
+  }
+  slot->lineOffset = lineOffset;
+  slot->lineLength = lineLength;
+  AlertEntry entry = {};
+  if (TryBuildAlertEntryFromLine(line, &entry)) {
+    slot->fields = entry.fields;
   }
-  return previousByte == '\n';
+  slot->rawLine = std::move(line);
+  return *slot;
 }
 
-ULONGLONG StartingLineNumberForOffset(HANDLE file, ULONGLONG offset) {
-  ULONGLONG lineNumber = CountLogicalLinesUpToOffset(file, offset);
-  if (offset > 0 && !DoesOffsetStartOnNewLine(file, offset) && lineNumber > 0) {
-    --lineNumber;
+bool ReadSpilledAlert(std::ifstream& inputFile, SpilledAlert* outAlert) {
+  UINT textLength = 0;
+  if (!ReadBinaryValue(inputFile, &outAlert->severity) ||
+      !ReadBinaryValue(inputFile, &outAlert->activeSeverity) ||
+      !ReadBinaryValue(inputFile, &outAlert->occurrenceCount) ||
+      !ReadBinaryValue(inputFile, &outAlert->lineNumber) ||
+      !ReadBinaryValue(inputFile, &outAlert->lastLineNumber) ||
+      !ReadBinaryValue(inputFile, &outAlert->lineOffset) ||
+      !ReadBinaryValue(inputFile, &outAlert->lineLength) ||
+      !ReadBinaryValue(inputFile, &outAlert->matchedIgnoreRuleId) ||
+      !ReadBinaryValue(inputFile, &outAlert->fields) ||
+      !ReadBinaryValue(inputFile, &textLength)) {
+    return false;
   }
-  return lineNumber;
+  outAlert->rawLine.resize(textLength);
+  return textLength == 0 || static_cast<bool>(inputFile.read(outAlert->rawLine.data(), textLength));
 }
 
-void AppendAlertEntryIfNeeded(
-    std::string_view line,
-    ULONGLONG lineNumber,
-    AlertSeverity* inOutHighestSeverity,
-    std::vector<AlertEntry>* outEntries) {
-  AlertEntry entry = {};
-  if (!TryBuildAlertEntryFromLine(line, &entry)) {
-    return;
+// Loads the page holding a spilled alert. The returned alert stays valid until the next lookup may
+// evict its page; nullptr when the spill file cannot be read.
+const SpilledAlert* SpilledAlertAt(AlertStore* store, size_t index) {
+  const size_t pageIndex = index / kSpilledAlertPageRecords;
+  const size_t firstIndex = pageIndex * kSpilledAlertPageRecords;
+  ++store->spilledPageUseCount;
+  SpilledAlertPage* slot = nullptr;
+  for (SpilledAlertPage& page : store->spilledPages) {
+    if (page.firstIndex == firstIndex && !page.alerts.empty()) {
+      page.lastUse = store->spilledPageUseCount;
+      return (index - firstIndex < page.alerts.size()) ? &page.alerts[index - firstIndex] : nullptr;
+    }
+    if (!slot || page.lastUse < slot->lastUse) {
+      slot = &page;
+    }
+  }
+  if (store->spilledPages.size() < kSpilledAlertPageCacheEntries) {
+    store->spilledPages.emplace_back();
+    slot = &store->spilledPages.back();
   }
 
-  entry.lineNumber = lineNumber;
-  const IgnoreRule* matchedRule = FindMatchingIgnoreRule(entry.rawLine);
-  if (matchedRule) {
-    entry.isIgnored = true;
-    entry.matchedIgnoreRuleText = matchedRule->text;
+  *slot = SpilledAlertPage{};
+  slot->lastUse = store->spilledPageUseCount;
+  std::ifstream inputFile(std::filesystem::path(g_state.alertSpillPath), std::ios::binary);
+  if (!inputFile.is_open() || !inputFile.seekg(static_cast<std::streamoff>(store->spillPageOffsets[pageIndex]))) {
+    DebugLog(L"Could not open the alert spill file. path=" + g_state.alertSpillPath);
+    return nullptr;
+  }
+  const size_t pageSize = (std::min)(kSpilledAlertPageRecords, store->spilledCount - firstIndex);
+  slot->alerts.resize(pageSize);
+  for (SpilledAlert& alert : slot->alerts) {
+    if (!ReadSpilledAlert(inputFile, &alert)) {
+      DebugLog(L"Alert spill file is truncated or corrupt. path=" + g_state.alertSpillPath);
+      slot->alerts.clear();
+      return nullptr;
+    }
   }
-  UpdateAlertEntryPresentation(&entry);
+  slot->firstIndex = firstIndex;
+  return &slot->alerts[index - firstIndex];
+}
 
-  if (entry.isIgnored) {
-    DebugLog(L"Ignored alert while scanning: " + entry.summaryText);
+// Alerts [0, spilledCount) are on disk and the rest are resident. The view's text may live in a
+// cache (offsets-only lines, spilled pages), so it is only valid until the next StoredAlertView call.
+AlertView StoredAlertView(AlertStore* store, size_t index) {
+  AlertView alert = {};
+  UINT ruleId = kNoIgnoreRule;
+  ULONGLONG lineOffset = 0;
+  UINT lineLength = 0;
+  if (index < store->spilledCount) {
+    const SpilledAlert* spilled = SpilledAlertAt(store, index);
+    if (!spilled) {
+      alert.rawLine = "(this alert could not be read back from the spill file)";
+      return alert;
+    }
+    alert.severity = static_cast<AlertSeverity>(spilled->severity);
+    alert.isIgnored = spilled->activeSeverity == static_cast<unsigned char>(AlertSeverity::kNone);
+    alert.lineNumber = spilled->lineNumber;
+    alert.lastLineNumber = spilled->lastLineNumber;
+    alert.occurrenceCount = spilled->occurrenceCount;
+    alert.rawLine = spilled->rawLine;
+    alert.fields = spilled->fields;
+    ruleId = spilled->matchedIgnoreRuleId;
+    lineOffset = spilled->lineOffset;
+    lineLength = spilled->lineLength;
   } else {
-    if (inOutHighestSeverity) {
-      *inOutHighestSeverity = MaxAlertSeverity(*inOutHighestSeverity, entry.severity);
+    const size_t row = index - store->spilledCount;
+    alert.severity = static_cast<AlertSeverity>(store->severities[row]);
+    alert.isIgnored = store->activeSeverities[row] == static_cast<unsigned char>(AlertSeverity::kNone);
+    alert.lineNumber = store->lineNumbers[row];
+    alert.lastLineNumber = store->lastLineNumbers[row];
+    alert.occurrenceCount = store->occurrenceCounts[row];
+    if (!store->offsetsOnly) {
+      alert.rawLine = AlertArenaText(store->arena, store->rawLines[row]);
+      alert.fields = store->fields[row];
     }
-    DebugLog(L"Detected alert while scanning: " + entry.summaryText);
+    ruleId = store->matchedIgnoreRuleIds[row];
+    lineOffset = store->lineOffsets[row];
+    lineLength = store->lineLengths[row];
   }
 
-  if (outEntries) {
-    outEntries->push_back(std::move(entry));
+  if (store->ignoreRules && ruleId < store->ignoreRules->rules.size()) {
+    alert.matchedIgnoreRuleText = store->ignoreRules->rules[ruleId].text;
   }
+  if (store->offsetsOnly) {
+    const DecodedAlertLine& decoded = DecodeAlertLineAt(store, lineOffset, lineLength);
+    alert.rawLine = decoded.rawLine;
+    alert.fields = decoded.fields;
+    if (alert.rawLine.empty()) {
+      alert.rawLine = "(this line could not be read back from the log)";
+    }
+  }
+  return alert;
 }
 
-void UpdateListBoxHorizontalExtent(HWND listBoxHwnd) {
-  if (!listBoxHwnd || !IsWindow(listBoxHwnd)) {
+// Moves the oldest resident alerts to the append-only spill file until the store is back under three
+// quarters of its limits, so a storm spills in batches rather than one alert per append. Spilled
+// alerts are no longer aggregated: a later occurrence starts a new resident alert.
+void SpillOldestAlerts(AlertStore* store) {
+  const size_t residentCount = store->severities.size();
+  const size_t targetCount = (g_state.maxResidentAlerts != 0) ? g_state.maxResidentAlerts / 4 * 3 : residentCount;
+  const ULONGLONG targetBytes =
+      (g_state.maxResidentAlertBytes != 0) ? g_state.maxResidentAlertBytes / 4 * 3 : store->residentTextBytes;
+  size_t spillCount = (residentCount > targetCount) ? residentCount - targetCount : 0;
+  ULONGLONG remainingBytes = store->residentTextBytes;
+  for (size_t row = 0; row < spillCount; ++row) {
+    remainingBytes -= store->offsetsOnly ? 0 : store->rawLines[row].length;
+  }
+  for (; spillCount < residentCount && remainingBytes > targetBytes; ++spillCount) {
+    remainingBytes -= store->offsetsOnly ? 0 : store->rawLines[spillCount].length;
+  }
+  // The newest alert always stays resident.
+  spillCount = (std::min)(spillCount, residentCount - 1);
+  if (spillCount == 0) {
     return;
   }
 
-  const int itemCount = static_cast<int>(SendMessageW(listBoxHwnd, LB_GETCOUNT, 0, 0));
-  if (itemCount == LB_ERR || itemCount <= 0) {
-    SendMessageW(listBoxHwnd, LB_SETHORIZONTALEXTENT, 0, 0);
+  std::ofstream outputFile(
+      std::filesystem::path(g_state.alertSpillPath),
+      std::ios::binary | (store->spilledCount == 0 ? std::ios::trunc : std::ios::app));
+  if (!outputFile.is_open()) {
+    DebugLog(L"Failed to open the alert spill file; keeping alerts in memory. path=" + g_state.alertSpillPath);
     return;
   }
+  for (size_t row = 0; row < spillCount; ++row) {
+    if ((store->spilledCount + row) % kSpilledAlertPageRecords == 0) {
+      store->spillPageOffsets.push_back(store->spillFileBytes);
+    }
+    const std::string_view text =
+        store->offsetsOnly ? std::string_view() : AlertArenaText(store->arena, store->rawLines[row]);
+    WriteBinaryValue(outputFile, store->severities[row]);
+    WriteBinaryValue(outputFile, store->activeSeverities[row]);
+    WriteBinaryValue(outputFile, store->occurrenceCounts[row]);
+    WriteBinaryValue(outputFile, store->lineNumbers[row]);
+    WriteBinaryValue(outputFile, store->lastLineNumbers[row]);
+    WriteBinaryValue(outputFile, store->lineOffsets[row]);
+    WriteBinaryValue(outputFile, store->lineLengths[row]);
+    WriteBinaryValue(outputFile, store->matchedIgnoreRuleIds[row]);
+    WriteBinaryValue(outputFile, store->offsetsOnly ? AlertFieldSpans{} : store->fields[row]);
+    WriteBinaryValue(outputFile, static_cast<UINT>(text.size()));
+    outputFile.write(text.data(), static_cast<std::streamsize>(text.size()));
+    store->spillFileBytes += kSpilledAlertHeaderBytes + text.size();
+    store->spilledHighestActiveSeverity = (std::max)(store->spilledHighestActiveSeverity, store->activeSeverities[row]);
+    store->alertIndexByFingerprint.erase(store->fingerprints[row]);
+  }
+  if (!outputFile.good()) {
+    DebugLog(L"Writing the alert spill file failed. path=" + g_state.alertSpillPath);
+  }
+
+  const auto dropFront = [spillCount](auto& column) {
+    column.erase(column.begin(), column.begin() + static_cast<std::ptrdiff_t>(spillCount));
+  };
+  dropFront(store->severities);
+  dropFront(store->activeSeverities);
+  dropFront(store->fingerprints);
+  dropFront(store->occurrenceCounts);
+  dropFront(store->lineNumbers);
+  dropFront(store->lastLineNumbers);
+  dropFront(store->lineOffsets);
+  dropFront(store->lineLengths);
+  dropFront(store->matchedIgnoreRuleIds);
+  if (!store->offsetsOnly) {
+    dropFront(store->rawLines);
+    dropFront(store->fields);
+    // Text is appended in alert order, so every chunk before the oldest resident line is unused now.
+    for (UINT chunk = 0; chunk < store->rawLines.front().chunk; ++chunk) {
+      store->arena.chunks[chunk].reset();
+    }
+  }
+  store->spilledCount += spillCount;
+  store->residentTextBytes = remainingBytes;
+  store->spilledPages.clear();
+  store->appendJournal.erase(
+      std::remove_if(
+          store->appendJournal.begin(),
+          store->appendJournal.end(),
+          [store](const AlertAppendUndo& undo) { return undo.alertIndex < store->spilledCount; }),
+      store->appendJournal.end());
+  DebugLog(
+      L"Spilled " + std::to_wstring(spillCount) + L" alerts to disk. spilled=" +
+      std::to_wstring(store->spilledCount) + L", resident=" + std::to_wstring(store->severities.size()));
+}
 
-  HDC dc = GetDC(listBoxHwnd);
-  if (!dc) {
-    return;
+void AppendAlertToStore(AlertStore* store, const AlertEntry& entry) {
+  AlertAppendUndo undo = {};
+  const auto existing = store->alertIndexByFingerprint.find(entry.fingerprint);
+  if (existing != store->alertIndexByFingerprint.end()) {
+    const size_t row = existing->second - store->spilledCount;
+    undo.alertIndex = existing->second;
+    undo.previousLastLineNumber = store->lastLineNumbers[row];
+    ++store->occurrenceCounts[row];
+    store->lastLineNumbers[row] = entry.lineNumber;
+  } else {
+    undo.alertIndex = static_cast<UINT>(AlertCount(*store));
+    undo.createdAlert = true;
+    store->alertIndexByFingerprint.emplace(entry.fingerprint, undo.alertIndex);
+    store->severities.push_back(static_cast<unsigned char>(entry.severity));
+    store->activeSeverities.push_back(
+        static_cast<unsigned char>(entry.isIgnored ? AlertSeverity::kNone : entry.severity));
+    store->fingerprints.push_back(entry.fingerprint);
+    store->occurrenceCounts.push_back(1);
+    store->lineNumbers.push_back(entry.lineNumber);
+    store->lastLineNumbers.push_back(entry.lineNumber);
+    store->lineOffsets.push_back(entry.lineOffset);
+    store->lineLengths.push_back(static_cast<UINT>(entry.rawLine.size()));
+    store->matchedIgnoreRuleIds.push_back(entry.matchedIgnoreRuleId);
+    store->longestLineLength = (std::max)(store->longestLineLength, static_cast<UINT>(entry.rawLine.size()));
+    if (!store->offsetsOnly) {
+      store->rawLines.push_back(AppendAlertArenaText(&store->arena, entry.rawLine));
+      store->fields.push_back(entry.fields);
+      store->residentTextBytes += entry.rawLine.size();
+    }
   }
 
-  const HFONT font = reinterpret_cast<HFONT>(SendMessageW(listBoxHwnd, WM_GETFONT, 0, 0));
-  const HGDIOBJ oldFont = font ? SelectObject(dc, font) : nullptr;
-  int maxWidth = 0;
-  for (int i = 0; i < itemCount; ++i) {
-    const LRESULT textLength = SendMessageW(listBoxHwnd, LB_GETTEXTLEN, static_cast<WPARAM>(i), 0);
-    if (textLength == LB_ERR) {
+  if (store->appendJournal.size() == kAlertAppendJournalEntries) {
+    store->appendJournal.erase(store->appendJournal.begin());
+  }
+  store->appendJournal.push_back(undo);
+
+  if (undo.createdAlert &&
+      ((g_state.maxResidentAlerts != 0 && store->severities.size() > g_state.maxResidentAlerts) ||
+       (g_state.maxResidentAlertBytes != 0 && store->residentTextBytes > g_state.maxResidentAlertBytes))) {
+    SpillOldestAlerts(store);
+  }
+}
+
+void ClearAlertStore(AlertStore* store) {
+  if (store->logFile != INVALID_HANDLE_VALUE) {
+    CloseHandle(store->logFile);
+  }
+  if (store->spilledCount != 0) {
+    std::error_code removeError;
+    std::filesystem::remove(std::filesystem::path(g_state.alertSpillPath), removeError);
+  }
+  const bool offsetsOnly = store->offsetsOnly;
+  *store = AlertStore{};
+  store->offsetsOnly = offsetsOnly;
+}
+
+// Undoes the newest count appends; only those still in the journal can be undone, which covers the
+// entries of a retracted unterminated tail. Arena bytes of a removed alert are not reclaimed until the
+// next clear.
+void RetractNewestAlertOccurrences(AlertStore* store, size_t count) {
+  for (; count > 0 && !store->appendJournal.empty(); --count) {
+    const AlertAppendUndo undo = store->appendJournal.back();
+    store->appendJournal.pop_back();
+    if (!undo.createdAlert) {
+      const size_t row = undo.alertIndex - store->spilledCount;
+      --store->occurrenceCounts[row];
+      store->lastLineNumbers[row] = undo.previousLastLineNumber;
       continue;
     }
 
-    std::wstring text(static_cast<size_t>(textLength), L'\0');
-    SendMessageW(listBoxHwnd, LB_GETTEXT, static_cast<WPARAM>(i), reinterpret_cast<LPARAM>(text.data()));
-    SIZE textSize = {};
-    if (GetTextExtentPoint32W(dc, text.c_str(), static_cast<int>(text.size()), &textSize)) {
-      maxWidth = (std::max)(maxWidth, static_cast<int>(textSize.cx));
+    store->alertIndexByFingerprint.erase(store->fingerprints.back());
+    store->severities.pop_back();
+    store->activeSeverities.pop_back();
+    store->fingerprints.pop_back();
+    store->occurrenceCounts.pop_back();
+    store->lineNumbers.pop_back();
+    store->lastLineNumbers.pop_back();
+    store->lineOffsets.pop_back();
+    store->lineLengths.pop_back();
+    store->matchedIgnoreRuleIds.pop_back();
+    if (!store->offsetsOnly) {
+      store->residentTextBytes -= store->rawLines.back().length;
+      store->rawLines.pop_back();
+      store->fields.pop_back();
     }
   }
+  if (count > 0) {
+    DebugLog(L"Could not retract " + std::to_wstring(count) + L" alert occurrences; they are kept.");
+  }
+}
 
-  if (oldFont) {
-    SelectObject(dc, oldFont);
+struct LevelNameSeverity {
+  std::string_view name;
+  AlertSeverity severity = AlertSeverity::kNone;
+};
+
+constexpr LevelNameSeverity kLevelNames[] = {
+    {"debug", AlertSeverity::kNone},
+    {"info", AlertSeverity::kNone},
+    {"warn", AlertSeverity::kWarning},
+    {"error", AlertSeverity::kError},
+    {"dpanic", AlertSeverity::kError},
+    {"panic", AlertSeverity::kError},
+    {"fatal", AlertSeverity::kError},
+};
+
+// First letter and length are enough to tell the zap level names apart, so a level value costs one
+// table lookup and one short comparison against the name in its slot.
+constexpr size_t LevelNameHash(std::string_view name) {
+  return (static_cast<unsigned char>(name[0]) * 2 + name.size()) & (kLevelHashSlots - 1);
+}
+
+struct LevelHashTable {
+  LevelNameSeverity slots[kLevelHashSlots] = {};
+  bool collisionFree = true;
+};
+
+constexpr LevelHashTable BuildLevelHashTable() {
+  LevelHashTable table = {};
+  for (const LevelNameSeverity& level : kLevelNames) {
+    LevelNameSeverity& slot = table.slots[LevelNameHash(level.name)];
+    if (!slot.name.empty()) {
+      table.collisionFree = false;
+    }
+    slot = level;
   }
-  ReleaseDC(listBoxHwnd, dc);
-  SendMessageW(listBoxHwnd, LB_SETHORIZONTALEXTENT, static_cast<WPARAM>(maxWidth + 24), 0);
+  return table;
 }
 
-std::wstring FindNotepadPlusPlusPath() {
-  const DWORD bufferSize = SearchPathW(nullptr, L"notepad++.exe", nullptr, 0, nullptr, nullptr);
-  if (bufferSize > 0) {
-    std::vector<wchar_t> buffer(bufferSize);
-    if (SearchPathW(nullptr, L"notepad++.exe", nullptr, bufferSize, buffer.data(), nullptr) > 0) {
-      return std::wstring(buffer.data());
+constexpr LevelHashTable kLevelHashTable = BuildLevelHashTable();
+static_assert(kLevelHashTable.collisionFree, "LevelNameHash must map every level name to its own slot");
+
+// kNone for info, debug and anything that is not a known level name.
+AlertSeverity SeverityOfLevelName(std::string_view name) {
+  if (name.empty() || name.size() > kMaxLevelNameLength) {
+    return AlertSeverity::kNone;
+  }
+  const LevelNameSeverity& slot = kLevelHashTable.slots[LevelNameHash(name)];
+  return slot.name == name ? slot.severity : AlertSeverity::kNone;
+}
+
+// Severity of the level value that follows a "level":" prefix at prefixPos.
+AlertSeverity LevelSeverityAt(std::string_view data, size_t prefixPos) {
+  const std::string_view value = data.substr(prefixPos + kLevelKeyPrefix.size(), kMaxLevelNameLength + 1);
+  const size_t closingQuote = value.find('"');
+  if (closingQuote == std::string_view::npos) {
+    return AlertSeverity::kNone;
+  }
+  return SeverityOfLevelName(value.substr(0, closingQuote));
+}
+
+bool IsAtLeastMinimumAlertSeverity(AlertSeverity severity) {
+  return severity != AlertSeverity::kNone &&
+         static_cast<int>(severity) >= static_cast<int>(g_scanner.minimumAlertSeverity);
+}
+
+bool IsAlertLevelTokenAt(std::string_view data, size_t pos) {
+  return data.compare(pos, kLevelKeyPrefix.size(), kLevelKeyPrefix) == 0 &&
+         IsAtLeastMinimumAlertSeverity(LevelSeverityAt(data, pos));
+}
+
+size_t FindAlertLevelTokenScalar(std::string_view data, size_t from) {
+  for (size_t pos = data.find(kLevelKeyPrefix, from); pos != std::string_view::npos;
+       pos = data.find(kLevelKeyPrefix, pos + 1)) {
+    if (IsAlertLevelTokenAt(data, pos)) {
+      return pos;
     }
   }
+  return std::string_view::npos;
+}
 
-  const wchar_t* knownPaths[] = {
-      L"D:\\PROGRAMS_D\\Notepad++\\notepad++.exe",
-      L"C:\\Program Files\\Notepad++\\notepad++.exe",
-      L"C:\\Program Files (x86)\\Notepad++\\notepad++.exe",
-  };
-  for (const wchar_t* path : knownPaths) {
-    const DWORD attributes = GetFileAttributesW(path);
-    if (attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY) == 0) {
-      return path;
+size_t CountNewlinesScalar(std::string_view data) {
+  return static_cast<size_t>(std::count(data.begin(), data.end(), '\n'));
+}
+
+// Bit i of each mask describes byte i of a 64-byte block.
+struct JsonBlockMasks {
+  ULONGLONG quote = 0;
+  ULONGLONG backslash = 0;
+  ULONGLONG operators = 0;
+};
+
+constexpr size_t kJsonBlockSize = 64;
+
+bool IsJsonOperatorChar(char ch) {
+  return ch == '{' || ch == '}' || ch == '[' || ch == ']' || ch == ':' || ch == ',';
+}
+
+void ClassifyJsonBlockScalar(const char* block, JsonBlockMasks* outMasks) {
+  JsonBlockMasks masks = {};
+  for (size_t i = 0; i < kJsonBlockSize; ++i) {
+    const ULONGLONG bit = 1ull << i;
+    if (block[i] == '"') {
+      masks.quote |= bit;
+    } else if (block[i] == '\\') {
+      masks.backslash |= bit;
+    } else if (IsJsonOperatorChar(block[i])) {
+      masks.operators |= bit;
     }
   }
+  *outMasks = masks;
+}
 
-  return L"";
+#if defined(BACKREST_WATCHER_X86_SIMD)
+unsigned int CountTrailingZeroBits(unsigned int mask) {
+#if defined(_MSC_VER)
+  unsigned long index = 0;
+  _BitScanForward(&index, mask);
+  return static_cast<unsigned int>(index);
+#else
+  return static_cast<unsigned int>(__builtin_ctz(mask));
+#endif
 }
 
-void OpenLogFileAtLine(ULONGLONG lineNumber) {
-  const std::wstring notepadPlusPlusPath = FindNotepadPlusPlusPath();
-  if (!notepadPlusPlusPath.empty()) {
-    std::wstring args = L"-nosession -n";
-    args += std::to_wstring((std::max)(lineNumber, static_cast<ULONGLONG>(1)));
-    args += L" \"";
-    args += g_state.logPath;
-    args += L"\"";
-    const HINSTANCE result = ShellExecuteW(
-        nullptr,
-        L"open",
-        notepadPlusPlusPath.c_str(),
-        args.c_str(),
-        nullptr,
-        SW_SHOWNORMAL);
-    if (reinterpret_cast<INT_PTR>(result) > 32) {
-      return;
+// Both vector kernels test three bytes per position at once: the opening quote of "level", the
+// 'l' after it and the first letter of the value. Only positions whose value starts with
+// w/e/d/p/f survive, so the info lines that make up most of the log never leave the vector loop.
+size_t FindAlertLevelTokenSse2(std::string_view data, size_t from) {
+  constexpr size_t kBlockSize = 16;
+  const char* bytes = data.data();
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i letterL = _mm_set1_epi8('l');
+  const __m128i letterW = _mm_set1_epi8('w');
+  const __m128i letterE = _mm_set1_epi8('e');
+  const __m128i letterD = _mm_set1_epi8('d');
+  const __m128i letterP = _mm_set1_epi8('p');
+  const __m128i letterF = _mm_set1_epi8('f');
+
+  size_t pos = from;
+  while (pos + kLevelKeyPrefix.size() + kBlockSize <= data.size()) {
+    const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + pos));
+    const __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + pos + 1));
+    const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + pos + kLevelKeyPrefix.size()));
+    const __m128i valueMatch = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(value, letterW), _mm_cmpeq_epi8(value, letterE)),
+        _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(value, letterD), _mm_cmpeq_epi8(value, letterP)),
+            _mm_cmpeq_epi8(value, letterF)));
+    unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_and_si128(
+        _mm_and_si128(_mm_cmpeq_epi8(first, quote), _mm_cmpeq_epi8(second, letterL)),
+        valueMatch)));
+    while (mask != 0) {
+      const size_t candidate = pos + CountTrailingZeroBits(mask);
+      if (IsAlertLevelTokenAt(data, candidate)) {
+        return candidate;
+      }
+      mask &= mask - 1;
+    }
+    pos += kBlockSize;
+  }
+  return FindAlertLevelTokenScalar(data, pos);
+}
+
+BACKREST_WATCHER_TARGET_AVX2 size_t FindAlertLevelTokenAvx2(std::string_view data, size_t from) {
+  constexpr size_t kBlockSize = 32;
+  const char* bytes = data.data();
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i letterL = _mm256_set1_epi8('l');
+  const __m256i letterW = _mm256_set1_epi8('w');
+  const __m256i letterE = _mm256_set1_epi8('e');
+  const __m256i letterD = _mm256_set1_epi8('d');
+  const __m256i letterP = _mm256_set1_epi8('p');
+  const __m256i letterF = _mm256_set1_epi8('f');
+
+  size_t pos = from;
+  while (pos + kLevelKeyPrefix.size() + kBlockSize <= data.size()) {
+    const __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + pos));
+    const __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + pos + 1));
+    const __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + pos + kLevelKeyPrefix.size()));
+    const __m256i valueMatch = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(value, letterW), _mm256_cmpeq_epi8(value, letterE)),
+        _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(value, letterD), _mm256_cmpeq_epi8(value, letterP)),
+            _mm256_cmpeq_epi8(value, letterF)));
+    unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_and_si256(
+        _mm256_and_si256(_mm256_cmpeq_epi8(first, quote), _mm256_cmpeq_epi8(second, letterL)),
+        valueMatch)));
+    while (mask != 0) {
+      const size_t candidate = pos + CountTrailingZeroBits(mask);
+      if (IsAlertLevelTokenAt(data, candidate)) {
+        return candidate;
+      }
+      mask &= mask - 1;
+    }
+    pos += kBlockSize;
+  }
+  return FindAlertLevelTokenScalar(data, pos);
+}
+
+unsigned int JsonOperatorMaskSse2(__m128i bytes) {
+  const __m128i matches = _mm_or_si128(
+      _mm_or_si128(
+          _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('{')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('}'))),
+          _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('[')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8(']')))),
+      _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(':')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8(','))));
+  return static_cast<unsigned int>(_mm_movemask_epi8(matches));
+}
+
+void ClassifyJsonBlockSse2(const char* block, JsonBlockMasks* outMasks) {
+  JsonBlockMasks masks = {};
+  for (size_t lane = 0; lane < kJsonBlockSize; lane += 16) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + lane));
+    masks.quote |= static_cast<ULONGLONG>(static_cast<unsigned int>(
+                       _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('"')))))
+                   << lane;
+    masks.backslash |= static_cast<ULONGLONG>(static_cast<unsigned int>(
+                           _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\\')))))
+                       << lane;
+    masks.operators |= static_cast<ULONGLONG>(JsonOperatorMaskSse2(bytes)) << lane;
+  }
+  *outMasks = masks;
+}
+
+BACKREST_WATCHER_TARGET_AVX2 unsigned int JsonOperatorMaskAvx2(__m256i bytes) {
+  const __m256i matches = _mm256_or_si256(
+      _mm256_or_si256(
+          _mm256_or_si256(
+              _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('{')),
+              _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('}'))),
+          _mm256_or_si256(
+              _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('[')),
+              _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(']')))),
+      _mm256_or_si256(
+          _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(':')),
+          _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(','))));
+  return static_cast<unsigned int>(_mm256_movemask_epi8(matches));
+}
+
+BACKREST_WATCHER_TARGET_AVX2 void ClassifyJsonBlockAvx2(const char* block, JsonBlockMasks* outMasks) {
+  JsonBlockMasks masks = {};
+  for (size_t lane = 0; lane < kJsonBlockSize; lane += 32) {
+    const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + lane));
+    masks.quote |= static_cast<ULONGLONG>(static_cast<unsigned int>(
+                       _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('"')))))
+                   << lane;
+    masks.backslash |= static_cast<ULONGLONG>(static_cast<unsigned int>(
+                           _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\\')))))
+                       << lane;
+    masks.operators |= static_cast<ULONGLONG>(JsonOperatorMaskAvx2(bytes)) << lane;
+  }
+  *outMasks = masks;
+}
+
+// Byte counters are accumulated per lane and folded with SAD before they can overflow at 255.
+size_t CountNewlinesSse2(std::string_view data) {
+  constexpr size_t kBlockSize = 16;
+  const char* bytes = data.data();
+  const __m128i newline = _mm_set1_epi8('\n');
+  size_t count = 0;
+  size_t pos = 0;
+  while (data.size() - pos >= kBlockSize) {
+    const size_t blocks = (std::min)((data.size() - pos) / kBlockSize, static_cast<size_t>(255));
+    __m128i laneCounts = _mm_setzero_si128();
+    for (size_t block = 0; block < blocks; ++block) {
+      const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + pos));
+      laneCounts = _mm_sub_epi8(laneCounts, _mm_cmpeq_epi8(chunk, newline));
+      pos += kBlockSize;
+    }
+    const __m128i sums = _mm_sad_epu8(laneCounts, _mm_setzero_si128());
+    count += static_cast<size_t>(_mm_cvtsi128_si32(sums)) + static_cast<size_t>(_mm_extract_epi16(sums, 4));
+  }
+  return count + CountNewlinesScalar(data.substr(pos));
+}
+
+BACKREST_WATCHER_TARGET_AVX2 size_t CountNewlinesAvx2(std::string_view data) {
+  constexpr size_t kBlockSize = 32;
+  const char* bytes = data.data();
+  const __m256i newline = _mm256_set1_epi8('\n');
+  size_t count = 0;
+  size_t pos = 0;
+  while (data.size() - pos >= kBlockSize) {
+    const size_t blocks = (std::min)((data.size() - pos) / kBlockSize, static_cast<size_t>(255));
+    __m256i laneCounts = _mm256_setzero_si256();
+    for (size_t block = 0; block < blocks; ++block) {
+      const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + pos));
+      laneCounts = _mm256_sub_epi8(laneCounts, _mm256_cmpeq_epi8(chunk, newline));
+      pos += kBlockSize;
+    }
+    alignas(32) unsigned long long sums[4] = {};
+    _mm256_store_si256(reinterpret_cast<__m256i*>(sums), _mm256_sad_epu8(laneCounts, _mm256_setzero_si256()));
+    count += static_cast<size_t>(sums[0] + sums[1] + sums[2] + sums[3]);
+  }
+  return count + CountNewlinesScalar(data.substr(pos));
+}
+
+// wchar_t is UTF-16 on Windows but 32 bits wide elsewhere, so the zero-extension is done once or twice.
+size_t WidenAsciiSse2(const char* text, size_t size, wchar_t* out) {
+  constexpr size_t kBlockSize = 16;
+  const __m128i zero = _mm_setzero_si128();
+  size_t pos = 0;
+  for (; size - pos >= kBlockSize; pos += kBlockSize) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + pos));
+    if (_mm_movemask_epi8(bytes) != 0) {
+      break;
+    }
+    const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+    const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+    __m128i* dest = reinterpret_cast<__m128i*>(out + pos);
+    if constexpr (sizeof(wchar_t) == 2) {
+      _mm_storeu_si128(dest, low);
+      _mm_storeu_si128(dest + 1, high);
+    } else {
+      _mm_storeu_si128(dest, _mm_unpacklo_epi16(low, zero));
+      _mm_storeu_si128(dest + 1, _mm_unpackhi_epi16(low, zero));
+      _mm_storeu_si128(dest + 2, _mm_unpacklo_epi16(high, zero));
+      _mm_storeu_si128(dest + 3, _mm_unpackhi_epi16(high, zero));
+    }
+  }
+  return pos + backrest_watcher::WidenAsciiScalar(text + pos, size - pos, out + pos);
+}
+
+BACKREST_WATCHER_TARGET_AVX2 size_t WidenAsciiAvx2(const char* text, size_t size, wchar_t* out) {
+  constexpr size_t kBlockSize = 32;
+  size_t pos = 0;
+  for (; size - pos >= kBlockSize; pos += kBlockSize) {
+    const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + pos));
+    if (_mm256_movemask_epi8(bytes) != 0) {
+      break;
+    }
+    __m256i* dest = reinterpret_cast<__m256i*>(out + pos);
+    if constexpr (sizeof(wchar_t) == 2) {
+      _mm256_storeu_si256(dest, _mm256_cvtepu8_epi16(_mm256_castsi256_si128(bytes)));
+      _mm256_storeu_si256(dest + 1, _mm256_cvtepu8_epi16(_mm256_extracti128_si256(bytes, 1)));
+    } else {
+      const __m128i low = _mm256_castsi256_si128(bytes);
+      const __m128i high = _mm256_extracti128_si256(bytes, 1);
+      _mm256_storeu_si256(dest, _mm256_cvtepu8_epi32(low));
+      _mm256_storeu_si256(dest + 1, _mm256_cvtepu8_epi32(_mm_srli_si128(low, 8)));
+      _mm256_storeu_si256(dest + 2, _mm256_cvtepu8_epi32(high));
+      _mm256_storeu_si256(dest + 3, _mm256_cvtepu8_epi32(_mm_srli_si128(high, 8)));
+    }
+  }
+  return pos + backrest_watcher::WidenAsciiScalar(text + pos, size - pos, out + pos);
+}
+
+bool CpuSupportsAvx2() {
+#if defined(_MSC_VER)
+  int cpuInfo[4] = {};
+  __cpuid(cpuInfo, 0);
+  if (cpuInfo[0] < 7) {
+    return false;
+  }
+  __cpuid(cpuInfo, 1);
+  constexpr int kOsXsaveBit = 1 << 27;
+  constexpr int kAvxBit = 1 << 28;
+  if ((cpuInfo[2] & kOsXsaveBit) == 0 || (cpuInfo[2] & kAvxBit) == 0) {
+    return false;
+  }
+  if ((_xgetbv(0) & 0x6) != 0x6) {
+    return false;
+  }
+  __cpuidex(cpuInfo, 7, 0);
+  constexpr int kAvx2Bit = 1 << 5;
+  return (cpuInfo[1] & kAvx2Bit) != 0;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif
+
+struct ScanKernels {
+  const wchar_t* name = L"scalar";
+  size_t (*findAlertLevelToken)(std::string_view data, size_t from) = FindAlertLevelTokenScalar;
+  size_t (*countNewlines)(std::string_view data) = CountNewlinesScalar;
+  void (*classifyJsonBlock)(const char* block, JsonBlockMasks* outMasks) = ClassifyJsonBlockScalar;
+  backrest_watcher::WidenAsciiKernel widenAscii = backrest_watcher::WidenAsciiScalar;
+};
+
+ScanKernels DetectScanKernels() {
+  ScanKernels kernels = {};
+#if defined(BACKREST_WATCHER_X86_SIMD)
+  if (CpuSupportsAvx2()) {
+    kernels.name = L"avx2";
+    kernels.findAlertLevelToken = FindAlertLevelTokenAvx2;
+    kernels.countNewlines = CountNewlinesAvx2;
+    kernels.classifyJsonBlock = ClassifyJsonBlockAvx2;
+    kernels.widenAscii = WidenAsciiAvx2;
+  } else {
+    kernels.name = L"sse2";
+    kernels.findAlertLevelToken = FindAlertLevelTokenSse2;
+    kernels.countNewlines = CountNewlinesSse2;
+    kernels.classifyJsonBlock = ClassifyJsonBlockSse2;
+    kernels.widenAscii = WidenAsciiSse2;
+  }
+#endif
+  return kernels;
+}
+
+const ScanKernels& SelectedScanKernels() {
+  static const ScanKernels kernels = DetectScanKernels();
+  return kernels;
+}
+
+// Offset of the first "level":"..." token at or above the minimum alert level at or after from, or npos.
+size_t FindAlertLevelToken(std::string_view data, size_t from) {
+  return SelectedScanKernels().findAlertLevelToken(data, from);
+}
+
+size_t CountNewlines(std::string_view data) {
+  return SelectedScanKernels().countNewlines(data);
+}
+
+void AppendUtf8AsWide(std::string_view text, std::wstring* out) {
+  backrest_watcher::AppendUtf8AsWide(text, SelectedScanKernels().widenAscii, out);
+}
+
+unsigned int CountTrailingZeroBits64(ULONGLONG mask) {
+#if defined(_MSC_VER)
+  unsigned long index = 0;
+  if (_BitScanForward(&index, static_cast<unsigned long>(mask))) {
+    return static_cast<unsigned int>(index);
+  }
+  _BitScanForward(&index, static_cast<unsigned long>(mask >> 32));
+  return static_cast<unsigned int>(index) + 32;
+#else
+  return static_cast<unsigned int>(__builtin_ctzll(mask));
+#endif
+}
+
+// Bit i of the result is the XOR of bits 0..i of mask: set from an opening quote up to, but not
+// including, its closing quote.
+ULONGLONG PrefixXor(ULONGLONG mask) {
+  mask ^= mask << 1;
+  mask ^= mask << 2;
+  mask ^= mask << 4;
+  mask ^= mask << 8;
+  mask ^= mask << 16;
+  mask ^= mask << 32;
+  return mask;
+}
+
+// simdjson-style stage one: the selected kernel classifies 64 bytes at a time into quote, backslash
+// and operator bitmasks; escaped quotes are dropped, a prefix XOR over the remaining quotes yields the
+// in-string mask, and every quote plus every operator outside a string is recorded in file order.
+// Escape and string state carry across blocks, so only backslash runs are ever looked at bit by bit.
+void BuildJsonStructuralIndex(std::string_view json, std::vector<size_t>* outPositions) {
+  outPositions->clear();
+  const auto classifyJsonBlock = SelectedScanKernels().classifyJsonBlock;
+  ULONGLONG escapeCarry = 0;
+  ULONGLONG inStringCarry = 0;
+  for (size_t blockBegin = 0; blockBegin < json.size(); blockBegin += kJsonBlockSize) {
+    JsonBlockMasks masks = {};
+    if (json.size() - blockBegin >= kJsonBlockSize) {
+      classifyJsonBlock(json.data() + blockBegin, &masks);
+    } else {
+      char paddedBlock[kJsonBlockSize];
+      std::fill(std::begin(paddedBlock), std::end(paddedBlock), ' ');
+      std::copy(json.begin() + blockBegin, json.end(), paddedBlock);
+      classifyJsonBlock(paddedBlock, &masks);
+    }
+
+    ULONGLONG escaped = escapeCarry;
+    escapeCarry = 0;
+    ULONGLONG escapeStarts = masks.backslash & ~escaped;
+    while (escapeStarts != 0) {
+      const ULONGLONG bit = escapeStarts & (~escapeStarts + 1);
+      if ((bit >> 63) != 0) {
+        escapeCarry = 1;
+      } else {
+        escaped |= bit << 1;
+      }
+      escapeStarts &= ~(bit | (bit << 1));
+    }
+
+    const ULONGLONG quotes = masks.quote & ~escaped;
+    const ULONGLONG inString = PrefixXor(quotes) ^ inStringCarry;
+    inStringCarry = ((inString >> 63) != 0) ? ~0ull : 0;
+    ULONGLONG structural = quotes | (masks.operators & ~inString);
+    while (structural != 0) {
+      outPositions->push_back(blockBegin + CountTrailingZeroBits64(structural));
+      structural &= structural - 1;
     }
   }
+}
+
+void ResetLineCheckpoints(LineCheckpointIndex* index) {
+  if (index) {
+    index->checkpoints.clear();
+    index->fileIdentity = {};
+    index->hasFileIdentity = false;
+    index->dirty = true;
+  }
+}
+
+void DropLineCheckpointsBeyond(LineCheckpointIndex* index, ULONGLONG fileSize) {
+  if (!index) {
+    return;
+  }
+  while (!index->checkpoints.empty() && index->checkpoints.back().offset > fileSize) {
+    index->checkpoints.pop_back();
+    index->dirty = true;
+  }
+}
+
+bool TryGetLogFileIdentity(HANDLE file, LogFileIdentity* outIdentity) {
+  BY_HANDLE_FILE_INFORMATION information = {};
+  if (file == INVALID_HANDLE_VALUE || !outIdentity || !GetFileInformationByHandle(file, &information)) {
+    return false;
+  }
+  outIdentity->volumeSerialNumber = information.dwVolumeSerialNumber;
+  outIdentity->fileIndex =
+      (static_cast<ULONGLONG>(information.nFileIndexHigh) << 32) | information.nFileIndexLow;
+  return true;
+}
+
+bool IsSameLogFileIdentity(const LogFileIdentity& left, const LogFileIdentity& right) {
+  return left.volumeSerialNumber == right.volumeSerialNumber && left.fileIndex == right.fileIndex;
+}
+
+// Ties the index to the file behind the handle, discarding checkpoints that were built for another
+// file (the log was rotated or replaced since they were recorded).
+void BindLineCheckpointsToFile(HANDLE file, LineCheckpointIndex* index) {
+  LogFileIdentity identity = {};
+  if (!index || !TryGetLogFileIdentity(file, &identity)) {
+    return;
+  }
+  if (index->hasFileIdentity && IsSameLogFileIdentity(index->fileIdentity, identity)) {
+    return;
+  }
+
+  if (!index->checkpoints.empty()) {
+    DebugLog(
+        L"Line checkpoint index belongs to a different file. Discarding " +
+        std::to_wstring(index->checkpoints.size()) + L" checkpoints.");
+  }
+  index->checkpoints.clear();
+  index->fileIdentity = identity;
+  index->hasFileIdentity = true;
+  index->dirty = true;
+}
+
+// FNV-1a. Pass a previous result as seed to continue hashing a concatenation.
+ULONGLONG HashBytes(std::string_view data, ULONGLONG seed = 14695981039346656037ull) {
+  ULONGLONG hash = seed;
+  for (const char ch : data) {
+    hash ^= static_cast<unsigned char>(ch);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+bool TryHashBytesBeforeOffset(HANDLE file, ULONGLONG offset, ULONGLONG* outHash) {
+  const ULONGLONG begin = offset > kLineCheckpointHashWindowBytes ? offset - kLineCheckpointHashWindowBytes : 0;
+  const DWORD size = static_cast<DWORD>(offset - begin);
+  char buffer[kLineCheckpointHashWindowBytes];
+  LARGE_INTEGER filePointer = {};
+  filePointer.QuadPart = static_cast<LONGLONG>(begin);
+  DWORD bytesRead = 0;
+  if (!SetFilePointerEx(file, filePointer, nullptr, FILE_BEGIN) ||
+      !ReadFile(file, buffer, size, &bytesRead, nullptr) || bytesRead != size) {
+    return false;
+  }
+  *outHash = HashBytes(std::string_view(buffer, size));
+  return true;
+}
+
+// Nearest checkpoint at or before offset. Checkpoints loaded from disk are checked against the
+// file's current bytes before first use, oldest first, so a checkpoint is only trusted when every
+// earlier one still matches too. A mismatch means the log was rewritten in place: that checkpoint
+// and everything after it is dropped and the search falls back to the last one that matched.
+LineCheckpoint NearestLineCheckpoint(HANDLE file, LineCheckpointIndex* index, ULONGLONG offset) {
+  const auto it = std::upper_bound(
+      index->checkpoints.begin(),
+      index->checkpoints.end(),
+      offset,
+      [](ULONGLONG value, const LineCheckpoint& checkpoint) {
+        return value < checkpoint.offset;
+      });
+  const size_t candidateCount = static_cast<size_t>(it - index->checkpoints.begin());
+  for (size_t i = 0; i < candidateCount; ++i) {
+    LineCheckpoint& checkpoint = index->checkpoints[i];
+    if (checkpoint.verified) {
+      continue;
+    }
+
+    ULONGLONG contentHash = 0;
+    if (TryHashBytesBeforeOffset(file, checkpoint.offset, &contentHash) &&
+        contentHash == checkpoint.contentHash) {
+      checkpoint.verified = true;
+      continue;
+    }
+
+    DebugLog(
+        L"Line checkpoint at offset " + std::to_wstring(checkpoint.offset) +
+        L" no longer matches the log. Dropping it and later checkpoints.");
+    index->checkpoints.resize(i);
+    index->dirty = true;
+    return i == 0 ? LineCheckpoint{} : index->checkpoints[i - 1];
+  }
+  return candidateCount == 0 ? LineCheckpoint{} : index->checkpoints[candidateCount - 1];
+}
+
+// Sidecar layout: magic, volume serial, file index, checkpoint count, then offset / newline count /
+// content hash per checkpoint.
+void LoadLineCheckpointIndex(LineCheckpointIndex* index) {
+  ResetLineCheckpoints(index);
+  index->dirty = false;
+
+  std::ifstream inputFile(std::filesystem::path(g_state.lineIndexPath), std::ios::binary);
+  if (!inputFile.is_open()) {
+    DebugLog(L"Line checkpoint index file not found. path=" + g_state.lineIndexPath);
+    return;
+  }
+
+  char magic[kLineIndexFileMagic.size()] = {};
+  LogFileIdentity identity = {};
+  ULONGLONG count = 0;
+  if (!inputFile.read(magic, sizeof(magic)) ||
+      std::string_view(magic, sizeof(magic)) != kLineIndexFileMagic ||
+      !ReadBinaryValue(inputFile, &identity.volumeSerialNumber) ||
+      !ReadBinaryValue(inputFile, &identity.fileIndex) ||
+      !ReadBinaryValue(inputFile, &count)) {
+    DebugLog(L"Line checkpoint index file is not valid. Ignoring it.");
+    return;
+  }
+
+  std::vector<LineCheckpoint> checkpoints;
+  for (ULONGLONG i = 0; i < count; ++i) {
+    LineCheckpoint checkpoint = {};
+    if (!ReadBinaryValue(inputFile, &checkpoint.offset) ||
+        !ReadBinaryValue(inputFile, &checkpoint.newlineCount) ||
+        !ReadBinaryValue(inputFile, &checkpoint.contentHash) ||
+        checkpoint.newlineCount > checkpoint.offset ||
+        (!checkpoints.empty() && (checkpoint.offset <= checkpoints.back().offset ||
+                                  checkpoint.newlineCount < checkpoints.back().newlineCount))) {
+      DebugLog(L"Line checkpoint index file is truncated or corrupt. Ignoring it.");
+      return;
+    }
+    checkpoint.hasContentHash = true;
+    checkpoint.verified = false;
+    checkpoints.push_back(checkpoint);
+  }
+
+  index->checkpoints = std::move(checkpoints);
+  index->fileIdentity = identity;
+  index->hasFileIdentity = true;
+  DebugLog(L"Line checkpoint index loaded. count=" + std::to_wstring(index->checkpoints.size()));
+}
+
+void SaveLineCheckpointIndex(HANDLE file, LineCheckpointIndex* index) {
+  if (file == INVALID_HANDLE_VALUE || !index || !index->dirty || !index->hasFileIdentity ||
+      g_state.lineIndexPath.empty()) {
+    return;
+  }
+
+  LogFileIdentity identity = {};
+  if (!TryGetLogFileIdentity(file, &identity) || !IsSameLogFileIdentity(identity, index->fileIdentity)) {
+    DebugLog(L"Log file changed before the line checkpoint index could be saved.");
+    return;
+  }
+  for (size_t i = 0; i < index->checkpoints.size(); ++i) {
+    LineCheckpoint& checkpoint = index->checkpoints[i];
+    if (checkpoint.hasContentHash) {
+      continue;
+    }
+    if (!TryHashBytesBeforeOffset(file, checkpoint.offset, &checkpoint.contentHash)) {
+      index->checkpoints.resize(i);
+      break;
+    }
+    checkpoint.hasContentHash = true;
+  }
+
+  std::ofstream outputFile(std::filesystem::path(g_state.lineIndexPath), std::ios::binary | std::ios::trunc);
+  if (!outputFile.is_open()) {
+    DebugLog(L"Failed to open line checkpoint index for writing. path=" + g_state.lineIndexPath);
+    return;
+  }
+
+  outputFile.write(kLineIndexFileMagic.data(), static_cast<std::streamsize>(kLineIndexFileMagic.size()));
+  WriteBinaryValue(outputFile, index->fileIdentity.volumeSerialNumber);
+  WriteBinaryValue(outputFile, index->fileIdentity.fileIndex);
+  WriteBinaryValue(outputFile, static_cast<ULONGLONG>(index->checkpoints.size()));
+  for (const LineCheckpoint& checkpoint : index->checkpoints) {
+    WriteBinaryValue(outputFile, checkpoint.offset);
+    WriteBinaryValue(outputFile, checkpoint.newlineCount);
+    WriteBinaryValue(outputFile, checkpoint.contentHash);
+  }
+
+  outputFile.flush();
+  if (outputFile) {
+    index->dirty = false;
+  }
+  DebugLog(L"Line checkpoint index saved. count=" + std::to_wstring(index->checkpoints.size()));
+}
+
+ULONGLONG NextLineCheckpointDueOffset(const LineCheckpointIndex& index) {
+  const ULONGLONG lastOffset = index.checkpoints.empty() ? 0 : index.checkpoints.back().offset;
+  return lastOffset + kLineCheckpointIntervalBytes;
+}
+
+// Adds the newlines in segment (which starts at segmentOffset in the file) to *inOutNewlineCount,
+// splitting the count wherever a checkpoint is due so the index is grown without a second pass.
+void AdvanceNewlineCount(
+    std::string_view segment,
+    ULONGLONG segmentOffset,
+    ULONGLONG* inOutNewlineCount,
+    LineCheckpointIndex* index) {
+  if (!index) {
+    *inOutNewlineCount += CountNewlines(segment);
+    return;
+  }
+
+  while (!segment.empty()) {
+    const ULONGLONG dueOffset = NextLineCheckpointDueOffset(*index);
+    if (dueOffset <= segmentOffset) {
+      index->checkpoints.push_back({segmentOffset, *inOutNewlineCount});
+      index->dirty = true;
+      continue;
+    }
+    if (dueOffset > segmentOffset + segment.size()) {
+      *inOutNewlineCount += CountNewlines(segment);
+      return;
+    }
+
+    const size_t pieceSize = static_cast<size_t>(dueOffset - segmentOffset);
+    *inOutNewlineCount += CountNewlines(segment.substr(0, pieceSize));
+    index->checkpoints.push_back({dueOffset, *inOutNewlineCount});
+    index->dirty = true;
+    segment.remove_prefix(pieceSize);
+    segmentOffset = dueOffset;
+  }
+}
+
+// The line number preceding offset: the count of '\n' bytes before it. Only the bytes between the
+// nearest valid checkpoint and offset are read.
+ULONGLONG StartingLineNumberForOffset(HANDLE file, ULONGLONG offset, LineCheckpointIndex* index) {
+  if (file == INVALID_HANDLE_VALUE || offset == 0) {
+    return 0;
+  }
+
+  const LineCheckpoint start = index ? NearestLineCheckpoint(file, index, offset) : LineCheckpoint{};
+  LARGE_INTEGER filePointer = {};
+  filePointer.QuadPart = static_cast<LONGLONG>(start.offset);
+  if (!SetFilePointerEx(file, filePointer, nullptr, FILE_BEGIN)) {
+    return start.newlineCount;
+  }
+
+  constexpr DWORD kBufferSize = 64 * 1024;
+  char buffer[kBufferSize];
+  ULONGLONG position = start.offset;
+  ULONGLONG newlineCount = start.newlineCount;
+  while (position < offset) {
+    const DWORD toRead = static_cast<DWORD>(
+        std::min<ULONGLONG>(offset - position, static_cast<ULONGLONG>(kBufferSize)));
+    DWORD bytesRead = 0;
+    if (!ReadFile(file, buffer, toRead, &bytesRead, nullptr) || bytesRead == 0) {
+      break;
+    }
+
+    AdvanceNewlineCount(std::string_view(buffer, bytesRead), position, &newlineCount, index);
+    position += bytesRead;
+  }
+  return newlineCount;
+}
+
+// Occurrences of an alert differ only in their timestamp, so the fingerprint covers the same text a
+// suggested ignore rule does, plus the matched rule since that decides how the alert is shown.
+ULONGLONG AlertFingerprint(const AlertEntry& entry) {
+  std::string_view left;
+  std::string_view right;
+  SplitAlertLineAroundTs(ViewOfAlertEntry(entry), &left, &right);
+  const char separator = '\n';
+  ULONGLONG hash = HashBytes(left);
+  hash = HashBytes(std::string_view(&separator, 1), hash);
+  hash = HashBytes(right, hash);
+  return HashBytes(
+      std::string_view(reinterpret_cast<const char*>(&entry.matchedIgnoreRuleId), sizeof(entry.matchedIgnoreRuleId)),
+      hash);
+}
+
+// entry has its line, position and fields; matchedIgnoreRuleId indexes g_scanner.ignoreRules.
+void AppendClassifiedAlertEntry(
+    AlertEntry entry,
+    UINT matchedIgnoreRuleId,
+    AlertSeverity* inOutHighestSeverity,
+    std::vector<AlertEntry>* outEntries) {
+  entry.isIgnored = matchedIgnoreRuleId != kNoIgnoreRule;
+  entry.matchedIgnoreRuleId = matchedIgnoreRuleId;
+  entry.fingerprint = AlertFingerprint(entry);
+
+  if (!entry.isIgnored && inOutHighestSeverity) {
+    *inOutHighestSeverity = MaxAlertSeverity(*inOutHighestSeverity, entry.severity);
+  }
+  if (g_state.debugMode) {
+    DebugLog(
+        std::wstring(entry.isIgnored ? L"Ignored" : L"Detected") + L" alert while scanning: " +
+        AlertSummaryText(ViewOfAlertEntry(entry)));
+  }
+
+  if (outEntries) {
+    outEntries->push_back(std::move(entry));
+  }
+}
+
+void AppendAlertEntryIfNeeded(
+    std::string_view line,
+    ULONGLONG lineNumber,
+    ULONGLONG lineOffset,
+    AlertSeverity* inOutHighestSeverity,
+    std::vector<AlertEntry>* outEntries,
+    IgnoreMatchCost* ignoreMatchCost) {
+  AlertEntry entry = {};
+  if (!TryBuildAlertEntryFromLine(line, &entry)) {
+    return;
+  }
+
+  entry.lineNumber = lineNumber;
+  entry.lineOffset = lineOffset;
+  entry.rawLine = std::string(line);
+  const IgnoreRule* matchedRule = g_scanner.ignoreRules
+      ? FindMatchingIgnoreRule(*g_scanner.ignoreRules, entry.rawLine, entry.fields, ignoreMatchCost)
+      : nullptr;
+  const UINT matchedIgnoreRuleId =
+      matchedRule ? static_cast<UINT>(matchedRule - g_scanner.ignoreRules->rules.data()) : kNoIgnoreRule;
+  AppendClassifiedAlertEntry(std::move(entry), matchedIgnoreRuleId, inOutHighestSeverity, outEntries);
+}
+
+void UpdateListBoxHorizontalExtent(HWND listBoxHwnd) {
+  if (!listBoxHwnd || !IsWindow(listBoxHwnd)) {
+    return;
+  }
+
+  const int itemCount = static_cast<int>(SendMessageW(listBoxHwnd, LB_GETCOUNT, 0, 0));
+  if (itemCount == LB_ERR || itemCount <= 0) {
+    SendMessageW(listBoxHwnd, LB_SETHORIZONTALEXTENT, 0, 0);
+    return;
+  }
+
+  HDC dc = GetDC(listBoxHwnd);
+  if (!dc) {
+    return;
+  }
+
+  const HFONT font = reinterpret_cast<HFONT>(SendMessageW(listBoxHwnd, WM_GETFONT, 0, 0));
+  const HGDIOBJ oldFont = font ? SelectObject(dc, font) : nullptr;
+  int maxWidth = 0;
+  for (int i = 0; i < itemCount; ++i) {
+    const LRESULT textLength = SendMessageW(listBoxHwnd, LB_GETTEXTLEN, static_cast<WPARAM>(i), 0);
+    if (textLength == LB_ERR) {
+      continue;
+    }
+
+    std::wstring text(static_cast<size_t>(textLength), L'\0');
+    SendMessageW(listBoxHwnd, LB_GETTEXT, static_cast<WPARAM>(i), reinterpret_cast<LPARAM>(text.data()));
+    SIZE textSize = {};
+    if (GetTextExtentPoint32W(dc, text.c_str(), static_cast<int>(text.size()), &textSize)) {
+      maxWidth = (std::max)(maxWidth, static_cast<int>(textSize.cx));
+    }
+  }
+
+  if (oldFont) {
+    SelectObject(dc, oldFont);
+  }
+  ReleaseDC(listBoxHwnd, dc);
+  SendMessageW(listBoxHwnd, LB_SETHORIZONTALEXTENT, static_cast<WPARAM>(maxWidth + 24), 0);
+}
+
+// The active alerts list is owner-drawn without per-item data, so it holds no text of its own and
+// its width is estimated from the longest stored line instead of measured.
+void UpdateActiveAlertsListHorizontalExtent() {
+  const HWND listBoxHwnd = g_state.activeAlertsListHwnd;
+  if (!listBoxHwnd || !IsWindow(listBoxHwnd)) {
+    return;
+  }
+
+  HDC dc = GetDC(listBoxHwnd);
+  if (!dc) {
+    return;
+  }
+  const HFONT font = reinterpret_cast<HFONT>(SendMessageW(listBoxHwnd, WM_GETFONT, 0, 0));
+  const HGDIOBJ oldFont = font ? SelectObject(dc, font) : nullptr;
+  TEXTMETRICW metrics = {};
+  GetTextMetricsW(dc, &metrics);
+  if (oldFont) {
+    SelectObject(dc, oldFont);
+  }
+  ReleaseDC(listBoxHwnd, dc);
+
+  const ULONGLONG widthChars = AlertCount(g_state.activeAlerts) == 0
+                                   ? 0
+                                   : static_cast<ULONGLONG>(g_state.activeAlerts.longestLineLength) + 24;
+  const ULONGLONG width = (std::min)(
+      widthChars * static_cast<ULONGLONG>(metrics.tmAveCharWidth) + 24,
+      static_cast<ULONGLONG>((std::numeric_limits<short>::max)()));
+  SendMessageW(listBoxHwnd, LB_SETHORIZONTALEXTENT, static_cast<WPARAM>(width), 0);
+}
+
+// List rows are newest first.
+size_t ActiveAlertIndexFromListIndex(UINT listIndex) {
+  const size_t alertCount = AlertCount(g_state.activeAlerts);
+  return (listIndex < alertCount) ? alertCount - 1 - listIndex : alertCount;
+}
+
+void DrawActiveAlertsListItem(const DRAWITEMSTRUCT* drawItem) {
+  const bool selected = (drawItem->itemState & ODS_SELECTED) != 0;
+  FillRect(drawItem->hDC, &drawItem->rcItem, GetSysColorBrush(selected ? COLOR_HIGHLIGHT : COLOR_WINDOW));
+
+  const size_t alertIndex = ActiveAlertIndexFromListIndex(drawItem->itemID);
+  if (alertIndex < AlertCount(g_state.activeAlerts)) {
+    const std::wstring listText = FormatAlertListText(StoredAlertView(&g_state.activeAlerts, alertIndex));
+    RECT textRect = drawItem->rcItem;
+    textRect.left += 2;
+    SetBkMode(drawItem->hDC, TRANSPARENT);
+    SetTextColor(drawItem->hDC, GetSysColor(selected ? COLOR_HIGHLIGHTTEXT : COLOR_WINDOWTEXT));
+    DrawTextW(
+        drawItem->hDC,
+        listText.c_str(),
+        static_cast<int>(listText.size()),
+        &textRect,
+        DT_SINGLELINE | DT_NOPREFIX | DT_VCENTER);
+  }
+
+  if (drawItem->itemState & ODS_FOCUS) {
+    DrawFocusRect(drawItem->hDC, &drawItem->rcItem);
+  }
+}
+
+std::wstring FindNotepadPlusPlusPath() {
+  const DWORD bufferSize = SearchPathW(nullptr, L"notepad++.exe", nullptr, 0, nullptr, nullptr);
+  if (bufferSize > 0) {
+    std::vector<wchar_t> buffer(bufferSize);
+    if (SearchPathW(nullptr, L"notepad++.exe", nullptr, bufferSize, buffer.data(), nullptr) > 0) {
+      return std::wstring(buffer.data());
+    }
+  }
+
+  const wchar_t* knownPaths[] = {
+      L"D:\\PROGRAMS_D\\Notepad++\\notepad++.exe",
+      L"C:\\Program Files\\Notepad++\\notepad++.exe",
+      L"C:\\Program Files (x86)\\Notepad++\\notepad++.exe",
+  };
+  for (const wchar_t* path : knownPaths) {
+    const DWORD attributes = GetFileAttributesW(path);
+    if (attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY) == 0) {
+      return path;
+    }
+  }
+
+  return L"";
+}
+
+void OpenLogFileAtLine(ULONGLONG lineNumber) {
+  const std::wstring notepadPlusPlusPath = FindNotepadPlusPlusPath();
+  if (!notepadPlusPlusPath.empty()) {
+    std::wstring args = L"-nosession -n";
+    args += std::to_wstring((std::max)(lineNumber, static_cast<ULONGLONG>(1)));
+    args += L" \"";
+    args += g_state.logPath;
+    args += L"\"";
+    const HINSTANCE result = ShellExecuteW(
+        nullptr,
+        L"open",
+        notepadPlusPlusPath.c_str(),
+        args.c_str(),
+        nullptr,
+        SW_SHOWNORMAL);
+    if (reinterpret_cast<INT_PTR>(result) > 32) {
+      return;
+    }
+  }
+
+  OpenLogFile();
+}
+
+enum class PatternNodeKind {
+  kEmpty,
+  kByteSet,
+  kConcat,
+  kAlternate,
+  kRepeat,
+  kAssertBegin,
+  kAssertEnd,
+};
+
+// Parse tree of a re: or glob: pattern. A kByteSet node matches one byte from bytes or, when
+// matchesNonAscii is set, also any one non-ASCII UTF-8 character; that is how '.' and negated classes
+// stay character based while literals are plain bytes.
+struct PatternNode {
+  PatternNodeKind kind = PatternNodeKind::kEmpty;
+  ULONGLONG bytes[4] = {};
+  bool matchesNonAscii = false;
+  UINT minRepeat = 0;
+  UINT maxRepeat = 0;
+  std::vector<PatternNode> children;
+};
+
+struct PatternParser {
+  std::string_view text;
+  size_t pos = 0;
+  int depth = 0;
+};
+
+void AddPatternByteRange(PatternNode* node, unsigned int low, unsigned int high) {
+  for (unsigned int byte = low; byte <= high; ++byte) {
+    node->bytes[byte >> 6] |= 1ull << (byte & 63);
+  }
+}
+
+PatternNode PatternByteNode(unsigned char byte) {
+  PatternNode node = {};
+  node.kind = PatternNodeKind::kByteSet;
+  AddPatternByteRange(&node, byte, byte);
+  return node;
+}
+
+PatternNode PatternAnyCharacterNode() {
+  PatternNode node = {};
+  node.kind = PatternNodeKind::kByteSet;
+  AddPatternByteRange(&node, 0x00, 0x7F);
+  node.matchesNonAscii = true;
+  return node;
+}
+
+// Complements the ASCII part of a class; non-ASCII characters flip along with it.
+void NegatePatternClass(PatternNode* node) {
+  node->bytes[0] = ~node->bytes[0];
+  node->bytes[1] = ~node->bytes[1];
+  node->matchesNonAscii = !node->matchesNonAscii;
+}
+
+// A literal character; a multi-byte UTF-8 character becomes one unit so a quantifier applies to all of it.
+PatternNode ParsePatternLiteral(PatternParser* parser) {
+  const unsigned char lead = static_cast<unsigned char>(parser->text[parser->pos++]);
+  if (lead < 0xC0) {
+    return PatternByteNode(lead);
+  }
+  PatternNode sequence = {};
+  sequence.kind = PatternNodeKind::kConcat;
+  sequence.children.push_back(PatternByteNode(lead));
+  while (parser->pos < parser->text.size() && (static_cast<unsigned char>(parser->text[parser->pos]) & 0xC0) == 0x80) {
+    sequence.children.push_back(PatternByteNode(static_cast<unsigned char>(parser->text[parser->pos++])));
+  }
+  return sequence;
+}
+
+// \d, \w, \s and their upper-case negations, added to node's set.
+bool AddRegexShorthandClass(char letter, PatternNode* node) {
+  PatternNode shorthand = {};
+  switch (letter) {
+    case 'd':
+    case 'D':
+      AddPatternByteRange(&shorthand, '0', '9');
+      break;
+    case 'w':
+    case 'W':
+      AddPatternByteRange(&shorthand, '0', '9');
+      AddPatternByteRange(&shorthand, 'A', 'Z');
+      AddPatternByteRange(&shorthand, 'a', 'z');
+      AddPatternByteRange(&shorthand, '_', '_');
+      break;
+    case 's':
+    case 'S':
+      AddPatternByteRange(&shorthand, '\t', '\r');
+      AddPatternByteRange(&shorthand, ' ', ' ');
+      break;
+    default:
+      return false;
+  }
+  if (letter >= 'A' && letter <= 'Z') {
+    NegatePatternClass(&shorthand);
+  }
+  for (size_t i = 0; i < 4; ++i) {
+    node->bytes[i] |= shorthand.bytes[i];
+  }
+  node->matchesNonAscii = node->matchesNonAscii || shorthand.matchesNonAscii;
+  return true;
+}
+
+// The escape after a backslash, added to node's set. Back-references, word boundaries and other
+// escapes the engine cannot run in linear time are rejected.
+bool ParseRegexEscape(PatternParser* parser, PatternNode* node) {
+  if (parser->pos >= parser->text.size()) {
+    return false;
+  }
+  const char ch = parser->text[parser->pos++];
+  if (AddRegexShorthandClass(ch, node)) {
+    return true;
+  }
+  unsigned int byte = static_cast<unsigned char>(ch);
+  switch (ch) {
+    case 't':
+      byte = '\t';
+      break;
+    case 'n':
+      byte = '\n';
+      break;
+    case 'r':
+      byte = '\r';
+      break;
+    case 'f':
+      byte = '\f';
+      break;
+    case 'v':
+      byte = '\v';
+      break;
+    case 'x': {
+      unsigned int high = 0;
+      unsigned int low = 0;
+      if (parser->pos + 2 > parser->text.size() || !ParseHexDigit(parser->text[parser->pos], &high) ||
+          !ParseHexDigit(parser->text[parser->pos + 1], &low)) {
+        return false;
+      }
+      parser->pos += 2;
+      byte = (high << 4) | low;
+      break;
+    }
+    default:
+      if (byte >= 0x80 || std::isalnum(static_cast<int>(byte)) != 0) {
+        return false;
+      }
+      break;
+  }
+  AddPatternByteRange(node, byte, byte);
+  return true;
+}
+
+// The body of a [...] class after the '['. Members are ASCII; regex classes also take escapes.
+bool ParsePatternClass(PatternParser* parser, bool regexSyntax, PatternNode* outNode) {
+  PatternNode node = {};
+  node.kind = PatternNodeKind::kByteSet;
+  const std::string_view text = parser->text;
+  bool negated = false;
+  if (parser->pos < text.size() && (text[parser->pos] == '^' || (!regexSyntax && text[parser->pos] == '!'))) {
+    negated = true;
+    ++parser->pos;
+  }
+
+  bool first = true;
+  while (parser->pos < text.size() && (first || text[parser->pos] != ']')) {
+    first = false;
+    const unsigned char low = static_cast<unsigned char>(text[parser->pos++]);
+    if (regexSyntax && low == '\\') {
+      if (!ParseRegexEscape(parser, &node)) {
+        return false;
+      }
+      continue;
+    }
+    if (low >= 0x80) {
+      return false;
+    }
+    unsigned char high = low;
+    if (parser->pos + 1 < text.size() && text[parser->pos] == '-' && text[parser->pos + 1] != ']') {
+      high = static_cast<unsigned char>(text[parser->pos + 1]);
+      if (high >= 0x80 || high < low || (regexSyntax && high == '\\')) {
+        return false;
+      }
+      parser->pos += 2;
+    }
+    AddPatternByteRange(&node, low, high);
+  }
+  if (parser->pos >= text.size()) {
+    return false;
+  }
+  ++parser->pos;
+
+  if (negated) {
+    NegatePatternClass(&node);
+  }
+  *outNode = std::move(node);
+  return true;
+}
+
+bool ParseRegexAlternation(PatternParser* parser, PatternNode* outNode);
+
+bool ParseRegexAtom(PatternParser* parser, PatternNode* outNode) {
+  const std::string_view text = parser->text;
+  const char ch = text[parser->pos];
+  switch (ch) {
+    case '(': {
+      ++parser->pos;
+      if (++parser->depth > kMaxIgnorePatternDepth) {
+        return false;
+      }
+      if (text.substr(parser->pos, 2) == "?:") {
+        parser->pos += 2;
+      } else if (parser->pos < text.size() && text[parser->pos] == '?') {
+        return false;
+      }
+      if (!ParseRegexAlternation(parser, outNode) || parser->pos >= text.size() || text[parser->pos] != ')') {
+        return false;
+      }
+      ++parser->pos;
+      --parser->depth;
+      return true;
+    }
+    case '[':
+      ++parser->pos;
+      return ParsePatternClass(parser, true, outNode);
+    case '.':
+      ++parser->pos;
+      *outNode = PatternAnyCharacterNode();
+      return true;
+    case '^':
+    case '$':
+      ++parser->pos;
+      *outNode = PatternNode{};
+      outNode->kind = (ch == '^') ? PatternNodeKind::kAssertBegin : PatternNodeKind::kAssertEnd;
+      return true;
+    case '\\':
+      ++parser->pos;
+      *outNode = PatternNode{};
+      outNode->kind = PatternNodeKind::kByteSet;
+      return ParseRegexEscape(parser, outNode);
+    case ')':
+    case '*':
+    case '+':
+    case '?':
+    case '{':
+      return false;
+    default:
+      *outNode = ParsePatternLiteral(parser);
+      return true;
+  }
+}
+
+bool ParseRegexRepeatCount(PatternParser* parser, UINT* outCount) {
+  const std::string_view text = parser->text;
+  const size_t begin = parser->pos;
+  UINT count = 0;
+  while (parser->pos < text.size() && text[parser->pos] >= '0' && text[parser->pos] <= '9') {
+    count = count * 10 + static_cast<UINT>(text[parser->pos] - '0');
+    if (count > kMaxIgnorePatternRepeat) {
+      return false;
+    }
+    ++parser->pos;
+  }
+  *outCount = count;
+  return parser->pos > begin;
+}
+
+// *, +, ? or {m}, {m,}, {m,n} after an atom. A trailing '?' (lazy) does not change whether a line
+// matches, so it is accepted and dropped. A second quantifier, as in a** or a{2}{2}, is rejected like a
+// bad {m,n}: only groups then nest repeats, so kMaxIgnorePatternDepth bounds the parse tree and the
+// recursion that compiles it.
+bool ParseRegexQuantifier(PatternParser* parser, PatternNode* inOutNode) {
+  const std::string_view text = parser->text;
+  if (parser->pos >= text.size()) {
+    return true;
+  }
+  UINT minRepeat = 0;
+  UINT maxRepeat = kUnboundedPatternRepeat;
+  const char ch = text[parser->pos];
+  if (ch == '*') {
+    ++parser->pos;
+  } else if (ch == '+') {
+    minRepeat = 1;
+    ++parser->pos;
+  } else if (ch == '?') {
+    maxRepeat = 1;
+    ++parser->pos;
+  } else if (ch == '{') {
+    ++parser->pos;
+    if (!ParseRegexRepeatCount(parser, &minRepeat)) {
+      return false;
+    }
+    maxRepeat = minRepeat;
+    if (parser->pos < text.size() && text[parser->pos] == ',') {
+      ++parser->pos;
+      maxRepeat = kUnboundedPatternRepeat;
+      if (parser->pos < text.size() && text[parser->pos] != '}' && !ParseRegexRepeatCount(parser, &maxRepeat)) {
+        return false;
+      }
+    }
+    if (parser->pos >= text.size() || text[parser->pos] != '}' || maxRepeat < minRepeat) {
+      return false;
+    }
+    ++parser->pos;
+  } else {
+    return true;
+  }
+  if (parser->pos < text.size() && text[parser->pos] == '?') {
+    ++parser->pos;
+  }
+  if (parser->pos < text.size() &&
+      (text[parser->pos] == '*' || text[parser->pos] == '+' || text[parser->pos] == '?' || text[parser->pos] == '{')) {
+    return false;
+  }
+
+  PatternNode repeat = {};
+  repeat.kind = PatternNodeKind::kRepeat;
+  repeat.minRepeat = minRepeat;
+  repeat.maxRepeat = maxRepeat;
+  repeat.children.push_back(std::move(*inOutNode));
+  *inOutNode = std::move(repeat);
+  return true;
+}
+
+bool ParseRegexSequence(PatternParser* parser, PatternNode* outNode) {
+  PatternNode sequence = {};
+  sequence.kind = PatternNodeKind::kConcat;
+  const std::string_view text = parser->text;
+  while (parser->pos < text.size() && text[parser->pos] != '|' && text[parser->pos] != ')') {
+    PatternNode atom = {};
+    if (!ParseRegexAtom(parser, &atom) || !ParseRegexQuantifier(parser, &atom)) {
+      return false;
+    }
+    sequence.children.push_back(std::move(atom));
+  }
+  *outNode = std::move(sequence);
+  return true;
+}
+
+bool ParseRegexAlternation(PatternParser* parser, PatternNode* outNode) {
+  PatternNode alternation = {};
+  alternation.kind = PatternNodeKind::kAlternate;
+  while (true) {
+    PatternNode sequence = {};
+    if (!ParseRegexSequence(parser, &sequence)) {
+      return false;
+    }
+    alternation.children.push_back(std::move(sequence));
+    if (parser->pos >= parser->text.size() || parser->text[parser->pos] != '|') {
+      break;
+    }
+    ++parser->pos;
+  }
+  if (alternation.children.size() == 1) {
+    *outNode = std::move(alternation.children.front());
+  } else {
+    *outNode = std::move(alternation);
+  }
+  return true;
+}
+
+// Search semantics, like grep: the pattern may match anywhere unless it is anchored with ^ or $.
+bool ParseRegexPattern(std::string_view text, PatternNode* outNode) {
+  PatternParser parser = {};
+  parser.text = text;
+  return ParseRegexAlternation(&parser, outNode) && parser.pos == text.size();
+}
+
+// Globs match the whole text: * is any run of characters, ? one character and [...] or [!...] a class.
+bool ParseGlobPattern(std::string_view text, PatternNode* outNode) {
+  PatternNode sequence = {};
+  sequence.kind = PatternNodeKind::kConcat;
+  sequence.children.emplace_back();
+  sequence.children.back().kind = PatternNodeKind::kAssertBegin;
+  PatternParser parser = {};
+  parser.text = text;
+  while (parser.pos < text.size()) {
+    const char ch = text[parser.pos];
+    if (ch == '*') {
+      while (parser.pos < text.size() && text[parser.pos] == '*') {
+        ++parser.pos;
+      }
+      PatternNode repeat = {};
+      repeat.kind = PatternNodeKind::kRepeat;
+      repeat.maxRepeat = kUnboundedPatternRepeat;
+      repeat.children.push_back(PatternAnyCharacterNode());
+      sequence.children.push_back(std::move(repeat));
+    } else if (ch == '?') {
+      ++parser.pos;
+      sequence.children.push_back(PatternAnyCharacterNode());
+    } else if (ch == '[') {
+      ++parser.pos;
+      PatternNode characterClass = {};
+      if (!ParsePatternClass(&parser, false, &characterClass)) {
+        return false;
+      }
+      sequence.children.push_back(std::move(characterClass));
+    } else {
+      sequence.children.push_back(ParsePatternLiteral(&parser));
+    }
+  }
+  sequence.children.emplace_back();
+  sequence.children.back().kind = PatternNodeKind::kAssertEnd;
+  *outNode = std::move(sequence);
+  return true;
+}
+
+UINT AddPatternInstruction(IgnorePattern* pattern, PatternOp op, UINT next, UINT alternative = 0) {
+  PatternInstruction instruction = {};
+  instruction.op = op;
+  instruction.next = next;
+  instruction.alternative = alternative;
+  pattern->program.push_back(instruction);
+  return static_cast<UINT>(pattern->program.size() - 1);
+}
+
+UINT AddPatternByteSetInstruction(IgnorePattern* pattern, unsigned int low, unsigned int high, UINT next) {
+  const UINT index = AddPatternInstruction(pattern, PatternOp::kByteSet, next);
+  for (unsigned int byte = low; byte <= high; ++byte) {
+    pattern->program[index].bytes[byte >> 6] |= 1ull << (byte & 63);
+  }
+  return index;
+}
+
+// Thompson construction, emitted back to front: each node is compiled with the entry of whatever
+// follows it already known, so no patch lists are needed. Counted repeats are unrolled, which is why
+// the program size is capped.
+bool EmitPatternNode(const PatternNode& node, UINT next, IgnorePattern* pattern, UINT* outEntry) {
+  if (pattern->program.size() > kMaxIgnorePatternInstructions) {
+    return false;
+  }
+
+  switch (node.kind) {
+    case PatternNodeKind::kEmpty:
+      *outEntry = next;
+      return true;
+    case PatternNodeKind::kAssertBegin:
+      *outEntry = AddPatternInstruction(pattern, PatternOp::kAssertBegin, next);
+      return true;
+    case PatternNodeKind::kAssertEnd:
+      *outEntry = AddPatternInstruction(pattern, PatternOp::kAssertEnd, next);
+      return true;
+    case PatternNodeKind::kByteSet: {
+      const UINT bytes = AddPatternInstruction(pattern, PatternOp::kByteSet, next);
+      std::copy(std::begin(node.bytes), std::end(node.bytes), pattern->program[bytes].bytes);
+      if (!node.matchesNonAscii) {
+        *outEntry = bytes;
+        return true;
+      }
+      // A lead byte followed by as many continuation bytes as it announces.
+      const UINT oneContinuation = AddPatternByteSetInstruction(pattern, 0x80, 0xBF, next);
+      const UINT twoContinuations = AddPatternByteSetInstruction(pattern, 0x80, 0xBF, oneContinuation);
+      const UINT threeContinuations = AddPatternByteSetInstruction(pattern, 0x80, 0xBF, twoContinuations);
+      const UINT twoByteLead = AddPatternByteSetInstruction(pattern, 0xC0, 0xDF, oneContinuation);
+      const UINT threeByteLead = AddPatternByteSetInstruction(pattern, 0xE0, 0xEF, twoContinuations);
+      const UINT fourByteLead = AddPatternByteSetInstruction(pattern, 0xF0, 0xF7, threeContinuations);
+      const UINT longLeads = AddPatternInstruction(pattern, PatternOp::kSplit, threeByteLead, fourByteLead);
+      const UINT anyLead = AddPatternInstruction(pattern, PatternOp::kSplit, twoByteLead, longLeads);
+      *outEntry = AddPatternInstruction(pattern, PatternOp::kSplit, bytes, anyLead);
+      return true;
+    }
+    case PatternNodeKind::kConcat: {
+      UINT entry = next;
+      for (auto it = node.children.rbegin(); it != node.children.rend(); ++it) {
+        if (!EmitPatternNode(*it, entry, pattern, &entry)) {
+          return false;
+        }
+      }
+      *outEntry = entry;
+      return true;
+    }
+    case PatternNodeKind::kAlternate: {
+      UINT entry = 0;
+      if (!EmitPatternNode(node.children.back(), next, pattern, &entry)) {
+        return false;
+      }
+      for (size_t i = node.children.size() - 1; i-- > 0;) {
+        UINT branch = 0;
+        if (!EmitPatternNode(node.children[i], next, pattern, &branch)) {
+          return false;
+        }
+        entry = AddPatternInstruction(pattern, PatternOp::kSplit, branch, entry);
+      }
+      *outEntry = entry;
+      return true;
+    }
+    case PatternNodeKind::kRepeat: {
+      const PatternNode& child = node.children.front();
+      UINT entry = next;
+      if (node.maxRepeat == kUnboundedPatternRepeat) {
+        const UINT loop = AddPatternInstruction(pattern, PatternOp::kSplit, 0, next);
+        UINT body = 0;
+        if (!EmitPatternNode(child, loop, pattern, &body)) {
+          return false;
+        }
+        pattern->program[loop].next = body;
+        entry = loop;
+      } else {
+        for (UINT i = node.minRepeat; i < node.maxRepeat; ++i) {
+          UINT body = 0;
+          if (!EmitPatternNode(child, entry, pattern, &body)) {
+            return false;
+          }
+          entry = AddPatternInstruction(pattern, PatternOp::kSplit, body, next);
+        }
+      }
+      for (UINT i = 0; i < node.minRepeat; ++i) {
+        if (!EmitPatternNode(child, entry, pattern, &entry)) {
+          return false;
+        }
+      }
+      *outEntry = entry;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool CompileIgnorePattern(const PatternNode& root, IgnorePattern* outPattern) {
+  IgnorePattern pattern;
+  const UINT match = AddPatternInstruction(&pattern, PatternOp::kMatch, 0);
+  if (!EmitPatternNode(root, match, &pattern, &pattern.start) ||
+      pattern.program.size() > kMaxIgnorePatternInstructions) {
+    return false;
+  }
+  pattern.anchoredStart = pattern.program[pattern.start].op == PatternOp::kAssertBegin;
+  *outPattern = std::move(pattern);
+  return true;
+}
+
+// Appends the text node matches when that is one fixed string.
+bool AppendPatternLiteral(const PatternNode& node, std::string* outLiteral) {
+  if (node.kind == PatternNodeKind::kConcat) {
+    return std::all_of(
+        node.children.begin(),
+        node.children.end(),
+        [outLiteral](const PatternNode& child) {
+          return AppendPatternLiteral(child, outLiteral);
+        });
+  }
+  if (node.kind != PatternNodeKind::kByteSet || node.matchesNonAscii) {
+    return false;
+  }
+  int byteCount = 0;
+  unsigned int literalByte = 0;
+  for (unsigned int byte = 0; byte < 256; ++byte) {
+    if ((node.bytes[byte >> 6] >> (byte & 63)) & 1) {
+      ++byteCount;
+      literalByte = byte;
+    }
+  }
+  if (byteCount != 1) {
+    return false;
+  }
+  outLiteral->push_back(static_cast<char>(literalByte));
+  return true;
+}
+
+// The longest run of fixed text in the top-level sequence; every match contains it.
+std::string LongestPatternLiteral(const PatternNode& root) {
+  std::string longest;
+  if (root.kind != PatternNodeKind::kConcat) {
+    return AppendPatternLiteral(root, &longest) ? longest : std::string();
+  }
+  std::string run;
+  for (const PatternNode& child : root.children) {
+    const size_t runSize = run.size();
+    if (AppendPatternLiteral(child, &run)) {
+      continue;
+    }
+    run.resize(runSize);
+    if (run.size() > longest.size()) {
+      longest = run;
+    }
+    run.clear();
+  }
+  return (run.size() > longest.size()) ? run : longest;
+}
+
+// Per-thread state lists for IgnorePatternMatches. An instruction is on a list only if its mark is
+// the current one.
+struct PatternRunScratch {
+  std::vector<UINT> current;
+  std::vector<UINT> next;
+  std::vector<UINT> stack;
+  std::vector<UINT> marks;
+  UINT mark = 0;
+};
+
+void AdvancePatternMark(PatternRunScratch* scratch) {
+  if (++scratch->mark == 0) {
+    std::fill(scratch->marks.begin(), scratch->marks.end(), 0);
+    scratch->mark = 1;
+  }
+}
+
+// Adds pc and every instruction reachable from it without consuming a byte to list. Returns true as
+// soon as the match instruction is reached.
+bool AddPatternThread(
+    const IgnorePattern& pattern,
+    UINT pc,
+    size_t pos,
+    size_t textSize,
+    PatternRunScratch* scratch,
+    std::vector<UINT>* list) {
+  scratch->stack.clear();
+  scratch->stack.push_back(pc);
+  while (!scratch->stack.empty()) {
+    const UINT current = scratch->stack.back();
+    scratch->stack.pop_back();
+    if (scratch->marks[current] == scratch->mark) {
+      continue;
+    }
+    scratch->marks[current] = scratch->mark;
+    const PatternInstruction& instruction = pattern.program[current];
+    switch (instruction.op) {
+      case PatternOp::kByteSet:
+        list->push_back(current);
+        break;
+      case PatternOp::kSplit:
+        scratch->stack.push_back(instruction.alternative);
+        scratch->stack.push_back(instruction.next);
+        break;
+      case PatternOp::kAssertBegin:
+        if (pos == 0) {
+          scratch->stack.push_back(instruction.next);
+        }
+        break;
+      case PatternOp::kAssertEnd:
+        if (pos == textSize) {
+          scratch->stack.push_back(instruction.next);
+        }
+        break;
+      case PatternOp::kMatch:
+        return true;
+    }
+  }
+  return false;
+}
+
+// Runs the NFA over text with one state set per position, so the cost is bounded by the text length
+// times the program size whatever the pattern. Unanchored patterns start a new thread at every byte.
+bool IgnorePatternMatches(const IgnorePattern& pattern, std::string_view text) {
+  thread_local PatternRunScratch scratch;
+  if (scratch.marks.size() < pattern.program.size()) {
+    scratch.marks.resize(pattern.program.size(), 0);
+  }
+
+  AdvancePatternMark(&scratch);
+  scratch.current.clear();
+  if (AddPatternThread(pattern, pattern.start, 0, text.size(), &scratch, &scratch.current)) {
+    return true;
+  }
+  for (size_t pos = 0; pos < text.size(); ++pos) {
+    if (scratch.current.empty() && pattern.anchoredStart) {
+      return false;
+    }
+    AdvancePatternMark(&scratch);
+    scratch.next.clear();
+    const unsigned char byte = static_cast<unsigned char>(text[pos]);
+    for (const UINT pc : scratch.current) {
+      const PatternInstruction& instruction = pattern.program[pc];
+      if (((instruction.bytes[byte >> 6] >> (byte & 63)) & 1) != 0 &&
+          AddPatternThread(pattern, instruction.next, pos + 1, text.size(), &scratch, &scratch.next)) {
+        return true;
+      }
+    }
+    if (!pattern.anchoredStart &&
+        AddPatternThread(pattern, pattern.start, pos + 1, text.size(), &scratch, &scratch.next)) {
+      return true;
+    }
+    std::swap(scratch.current, scratch.next);
+  }
+  return false;
+}
+
+// Text that the log's JSON encoder writes unchanged, so finding it in the raw line is a valid
+// prefilter for a pattern on a decoded field value.
+bool IsJsonVerbatimText(std::string_view text) {
+  return std::all_of(text.begin(), text.end(), [](char ch) {
+    return ch >= 0x20 && ch <= 0x7E && ch != '"' && ch != '\\' && ch != '<' && ch != '>' && ch != '&';
+  });
+}
+
+// "name=value" where name is one of kIgnoreFieldNames; anything else is a substring part.
+bool TryParseIgnoreFieldTerm(std::string_view term, IgnoreFieldTerm* outTerm) {
+  const size_t equalsPos = term.find('=');
+  if (equalsPos == std::string_view::npos) {
+    return false;
+  }
+  const std::string_view name = TrimAsciiWhitespace(term.substr(0, equalsPos));
+  for (const IgnoreFieldName& fieldName : kIgnoreFieldNames) {
+    if (fieldName.name == name) {
+      outTerm->field = fieldName.field;
+      outTerm->value = std::string(TrimAsciiWhitespace(term.substr(equalsPos + 1)));
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string_view IgnoreFieldDisplayName(IgnoreField field) {
+  for (const IgnoreFieldName& fieldName : kIgnoreFieldNames) {
+    if (fieldName.field == field) {
+      return fieldName.name;
+    }
+  }
+  return {};
+}
+
+// re:... or glob:..., optionally after "name=" to scope it to a field. A pattern that does not parse
+// or is too large to compile is left to be read as a plain part.
+bool TryParseIgnorePatternTerm(std::string_view term, IgnorePatternTerm* outTerm) {
+  IgnorePatternTerm patternTerm = {};
+  std::string_view patternSource = term;
+  IgnoreFieldTerm fieldTerm = {};
+  if (TryParseIgnoreFieldTerm(term, &fieldTerm)) {
+    patternTerm.fieldScoped = true;
+    patternTerm.field = fieldTerm.field;
+    patternSource = fieldTerm.value;
+  }
+  if (patternSource.substr(0, kGlobIgnorePrefix.size()) == kGlobIgnorePrefix) {
+    patternTerm.glob = true;
+    patternTerm.patternText = std::string(patternSource.substr(kGlobIgnorePrefix.size()));
+  } else if (patternSource.substr(0, kRegexIgnorePrefix.size()) == kRegexIgnorePrefix) {
+    patternTerm.patternText = std::string(patternSource.substr(kRegexIgnorePrefix.size()));
+  } else {
+    return false;
+  }
 
-  OpenLogFile();
+  PatternNode root = {};
+  const bool parsed = patternTerm.glob ? ParseGlobPattern(patternTerm.patternText, &root)
+                                       : ParseRegexPattern(patternTerm.patternText, &root);
+  auto pattern = std::make_shared<IgnorePattern>();
+  if (!parsed || !CompileIgnorePattern(root, pattern.get())) {
+    DebugLog(L"Ignore rule part is not a usable pattern and is matched as written: " + Utf8ToWide(term));
+    return false;
+  }
+  patternTerm.pattern = std::move(pattern);
+  patternTerm.requiredLiteral = LongestPatternLiteral(root);
+  if (patternTerm.fieldScoped && !IsJsonVerbatimText(patternTerm.requiredLiteral)) {
+    patternTerm.requiredLiteral.clear();
+  }
+  *outTerm = std::move(patternTerm);
+  return true;
 }
 
 bool TryBuildIgnoreRule(std::string_view line, IgnoreRule* outRule) {
@@ -1120,7 +3657,13 @@ bool TryBuildIgnoreRule(std::string_view line, IgnoreRule* outRule) {
     const size_t termLength =
         (separatorPos == std::string_view::npos) ? (parseText.size() - termStart) : (separatorPos - termStart);
     const std::string_view term = TrimAsciiWhitespace(parseText.substr(termStart, termLength));
-    if (!term.empty()) {
+    IgnorePatternTerm patternTerm = {};
+    IgnoreFieldTerm fieldTerm = {};
+    if (TryParseIgnorePatternTerm(term, &patternTerm)) {
+      rule.patternTerms.push_back(std::move(patternTerm));
+    } else if (TryParseIgnoreFieldTerm(term, &fieldTerm)) {
+      rule.fieldTerms.push_back(std::move(fieldTerm));
+    } else if (!term.empty()) {
       rule.requiredTerms.emplace_back(term);
     }
     if (separatorPos == std::string_view::npos) {
@@ -1129,7 +3672,7 @@ bool TryBuildIgnoreRule(std::string_view line, IgnoreRule* outRule) {
     termStart = separatorPos + kIgnoreRuleSeparator.size();
   }
 
-  if (rule.requiredTerms.empty()) {
+  if (rule.requiredTerms.empty() && rule.fieldTerms.empty() && rule.patternTerms.empty()) {
     return false;
   }
 
@@ -1141,73 +3684,378 @@ std::string SerializeIgnoreRule(const IgnoreRule& rule) {
   return rule.text;
 }
 
-std::wstring IgnoreRuleDisplayText(const IgnoreRule& rule) {
-  return Utf8ToWide(rule.text);
+ULONGLONG PerformanceCounterTicks() {
+  LARGE_INTEGER counter = {};
+  QueryPerformanceCounter(&counter);
+  return static_cast<ULONGLONG>(counter.QuadPart);
+}
+
+double PerformanceTicksToMilliseconds(ULONGLONG ticks) {
+  LARGE_INTEGER frequency = {};
+  QueryPerformanceFrequency(&frequency);
+  return frequency.QuadPart > 0 ? static_cast<double>(ticks) * 1000.0 / static_cast<double>(frequency.QuadPart) : 0.0;
+}
+
+std::wstring FormatMilliseconds(ULONGLONG ticks) {
+  wchar_t buffer[64] = {};
+  StringCchPrintfW(buffer, ARRAYSIZE(buffer), L"%.3f ms", PerformanceTicksToMilliseconds(ticks));
+  return buffer;
+}
+
+// The hit count comes first so that rules that never match stand out in the list.
+std::wstring IgnoreRuleDisplayText(const IgnoreRule& rule, const IgnoreRuleStats* stats) {
+  std::wstring displayText = L"[" + std::to_wstring(stats ? stats->hits : 0) + L" hits] ";
+  AppendUtf8AsWide(rule.text, &displayText);
+  return displayText;
 }
 
-std::wstring IgnoreRuleDetailsText(const IgnoreRule& rule) {
-  std::wstring details = (rule.requiredTerms.size() > 1)
-      ? L"Type: Contains all parts joined by &&"
-      : L"Type: Contains this part";
+std::wstring IgnoreRuleDetailsText(const IgnoreRule& rule, const IgnoreRuleStats* stats) {
+  std::wstring details = (rule.requiredTerms.size() + rule.fieldTerms.size() + rule.patternTerms.size() > 1)
+      ? L"Type: Matches all parts joined by &&"
+      : L"Type: Matches this part";
   details += L"\r\nRule: ";
-  details += Utf8ToWide(rule.text);
+  AppendUtf8AsWide(rule.text, &details);
   details += L"\r\n\r\nRequired parts:";
+  for (const IgnoreFieldTerm& fieldTerm : rule.fieldTerms) {
+    details += L"\r\n- ";
+    AppendUtf8AsWide(IgnoreFieldDisplayName(fieldTerm.field), &details);
+    details += L" is exactly: ";
+    AppendUtf8AsWide(fieldTerm.value, &details);
+  }
   for (const std::string& term : rule.requiredTerms) {
+    details += L"\r\n- contains: ";
+    AppendUtf8AsWide(term, &details);
+  }
+  for (const IgnorePatternTerm& patternTerm : rule.patternTerms) {
     details += L"\r\n- ";
-    details += Utf8ToWide(term);
+    if (patternTerm.fieldScoped) {
+      AppendUtf8AsWide(IgnoreFieldDisplayName(patternTerm.field), &details);
+      details += L" ";
+    }
+    details += patternTerm.glob ? L"matches glob: " : L"matches regex: ";
+    AppendUtf8AsWide(patternTerm.patternText, &details);
+  }
+  details += L"\r\n\r\nA log line is ignored only when it matches every part above.";
+
+  details += L"\r\n\r\nSince the last rescan:\r\n- Hits: " + std::to_wstring(stats ? stats->hits : 0);
+  details += L"\r\n- Last hit: ";
+  details += (stats && stats->hits != 0) ? L"line " + std::to_wstring(stats->lastHitLine) : std::wstring(L"never");
+  if (!rule.patternTerms.empty()) {
+    details += L"\r\n- Time in its regex and glob parts: " + FormatMilliseconds(stats ? stats->matchTicks : 0);
   }
-  details += L"\r\n\r\nA log line is ignored only when it contains every part above.";
+  details += L"\r\n- Time matching all rules: " + FormatMilliseconds(g_state.ignoreMatchTicks) + L" over " +
+             std::to_wstring(g_state.ignoreMatchLineCount) + L" alert lines";
   return details;
 }
 
+const IgnoreRuleStats* FindIgnoreRuleStats(const IgnoreRule& rule) {
+  const auto it = g_state.ignoreRuleStats.find(rule.text);
+  return (it != g_state.ignoreRuleStats.end()) ? &it->second : nullptr;
+}
+
 bool IsSameIgnoreRule(const IgnoreRule& left, const IgnoreRule& right) {
   return left.text == right.text;
 }
 
-bool DoesIgnoreRuleMatchLine(const IgnoreRule& rule, std::string_view rawLine) {
-  if (rule.requiredTerms.empty()) {
-    return false;
+UINT FindIgnoreTermChild(
+    const std::vector<std::pair<unsigned char, UINT>>& children,
+    unsigned char byte) {
+  const auto it = std::lower_bound(
+      children.begin(),
+      children.end(),
+      byte,
+      [](const std::pair<unsigned char, UINT>& child, unsigned char value) {
+        return child.first < value;
+      });
+  return (it != children.end() && it->first == byte) ? it->second : kNoIgnoreTermState;
+}
+
+struct IgnoreTermId {
+  std::string_view text;
+  UINT termId = 0;
+};
+
+void BuildIgnoreTermAutomaton(const std::vector<IgnoreTermId>& terms, IgnoreTermAutomaton* outAutomaton) {
+  IgnoreTermAutomaton automaton;
+  automaton.states.resize(1);
+
+  // The trie keeps its children as sorted lists while it is built and is flattened afterwards.
+  std::vector<std::vector<std::pair<unsigned char, UINT>>> children(1);
+  for (const IgnoreTermId& term : terms) {
+    UINT state = 0;
+    for (const char ch : term.text) {
+      const unsigned char byte = static_cast<unsigned char>(ch);
+      UINT next = FindIgnoreTermChild(children[state], byte);
+      if (next == kNoIgnoreTermState) {
+        next = static_cast<UINT>(automaton.states.size());
+        automaton.states.emplace_back();
+        children.emplace_back();
+        auto& stateChildren = children[state];
+        const auto position = std::find_if(
+            stateChildren.begin(),
+            stateChildren.end(),
+            [byte](const std::pair<unsigned char, UINT>& child) {
+              return child.first > byte;
+            });
+        stateChildren.insert(position, {byte, next});
+      }
+      state = next;
+    }
+    automaton.states[state].term = term.termId;
+  }
+
+  // Breadth first, so every failure target is finished before the states that point at it.
+  std::vector<UINT> queue;
+  for (const auto& child : children[0]) {
+    automaton.rootTransitions[child.first] = child.second;
+    queue.push_back(child.second);
+  }
+  for (size_t head = 0; head < queue.size(); ++head) {
+    const UINT state = queue[head];
+    const UINT failure = automaton.states[state].failure;
+    automaton.states[state].outputLink =
+        (automaton.states[failure].term != kNoIgnoreTerm) ? failure : automaton.states[failure].outputLink;
+    for (const auto& child : children[state]) {
+      UINT candidate = failure;
+      UINT childFailure = FindIgnoreTermChild(children[candidate], child.first);
+      while (childFailure == kNoIgnoreTermState && candidate != 0) {
+        candidate = automaton.states[candidate].failure;
+        childFailure = FindIgnoreTermChild(children[candidate], child.first);
+      }
+      automaton.states[child.second].failure = (childFailure == kNoIgnoreTermState) ? 0 : childFailure;
+      queue.push_back(child.second);
+    }
   }
 
-  return std::all_of(
-      rule.requiredTerms.begin(),
-      rule.requiredTerms.end(),
-      [rawLine](const std::string& term) {
-        return rawLine.find(term) != std::string_view::npos;
-      });
+  for (size_t state = 0; state < automaton.states.size(); ++state) {
+    automaton.states[state].firstEdge = static_cast<UINT>(automaton.edgeBytes.size());
+    automaton.states[state].edgeCount = static_cast<UINT>(children[state].size());
+    for (const auto& child : children[state]) {
+      automaton.edgeBytes.push_back(child.first);
+      automaton.edgeTargets.push_back(child.second);
+    }
+  }
+  *outAutomaton = std::move(automaton);
 }
 
-const IgnoreRule* FindMatchingIgnoreRule(std::string_view rawLine) {
-  const auto it = std::find_if(
-      g_state.ignoredRules.begin(),
-      g_state.ignoredRules.end(),
-      [rawLine](const IgnoreRule& rule) {
-        return DoesIgnoreRuleMatchLine(rule, rawLine);
-      });
-  if (it == g_state.ignoredRules.end()) {
-    return nullptr;
+std::shared_ptr<const IgnoreRuleSet> CompileIgnoreRuleSet(const std::vector<IgnoreRule>& rules) {
+  auto ruleSet = std::make_shared<IgnoreRuleSet>();
+  ruleSet->rules = rules;
+  ruleSet->ruleTermCounts.assign(rules.size(), 0);
+
+  std::unordered_map<std::string_view, UINT> substringTermIds;
+  std::vector<IgnoreTermId> substringTerms;
+  std::vector<std::vector<UINT>> rulesByTerm;
+  const auto requireTerm = [&ruleSet, &rulesByTerm](UINT termId, UINT ruleId) {
+    if (termId == rulesByTerm.size()) {
+      rulesByTerm.emplace_back();
+    }
+    std::vector<UINT>& termRules = rulesByTerm[termId];
+    if (termRules.empty() || termRules.back() != ruleId) {
+      termRules.push_back(ruleId);
+      ++ruleSet->ruleTermCounts[ruleId];
+    }
+  };
+  for (size_t ruleIndex = 0; ruleIndex < ruleSet->rules.size(); ++ruleIndex) {
+    const UINT ruleId = static_cast<UINT>(ruleIndex);
+    const IgnoreRule& rule = ruleSet->rules[ruleIndex];
+    for (const std::string& term : rule.requiredTerms) {
+      const auto inserted = substringTermIds.emplace(term, static_cast<UINT>(rulesByTerm.size()));
+      if (inserted.second) {
+        substringTerms.push_back({term, inserted.first->second});
+      }
+      requireTerm(inserted.first->second, ruleId);
+    }
+    for (const IgnoreFieldTerm& fieldTerm : rule.fieldTerms) {
+      auto& valueTermIds = ruleSet->fieldValueTermIds[static_cast<size_t>(fieldTerm.field)];
+      const auto inserted = valueTermIds.emplace(fieldTerm.value, static_cast<UINT>(rulesByTerm.size()));
+      requireTerm(inserted.first->second, ruleId);
+    }
+    for (const IgnorePatternTerm& patternTerm : rule.patternTerms) {
+      if (patternTerm.requiredLiteral.empty()) {
+        continue;
+      }
+      const auto inserted =
+          substringTermIds.emplace(patternTerm.requiredLiteral, static_cast<UINT>(rulesByTerm.size()));
+      if (inserted.second) {
+        substringTerms.push_back({patternTerm.requiredLiteral, inserted.first->second});
+      }
+      requireTerm(inserted.first->second, ruleId);
+    }
+    if (ruleSet->ruleTermCounts[ruleId] == 0) {
+      ruleSet->patternOnlyRuleIds.push_back(ruleId);
+    }
+  }
+  BuildIgnoreTermAutomaton(substringTerms, &ruleSet->automaton);
+
+  ruleSet->termRuleBegins.reserve(rulesByTerm.size() + 1);
+  for (const std::vector<UINT>& termRules : rulesByTerm) {
+    ruleSet->termRuleBegins.push_back(static_cast<UINT>(ruleSet->termRuleIds.size()));
+    ruleSet->termRuleIds.insert(ruleSet->termRuleIds.end(), termRules.begin(), termRules.end());
   }
-  return &(*it);
+  ruleSet->termRuleBegins.push_back(static_cast<UINT>(ruleSet->termRuleIds.size()));
+  return ruleSet;
 }
 
-std::string BuildSuggestedIgnoreRuleText(std::string_view line) {
-  const std::string_view trimmedLine = TrimAsciiWhitespace(line);
-  size_t tsFieldPos = 0;
-  size_t tsFieldEnd = 0;
-  if (!TryFindJsonFieldRange(trimmedLine, "ts", &tsFieldPos, &tsFieldEnd)) {
-    return std::string(trimmedLine);
+UINT NextIgnoreTermState(const IgnoreTermAutomaton& automaton, UINT state, unsigned char byte) {
+  while (state != 0) {
+    const IgnoreTermState& current = automaton.states[state];
+    const unsigned char* edgesBegin = automaton.edgeBytes.data() + current.firstEdge;
+    const unsigned char* edgesEnd = edgesBegin + current.edgeCount;
+    const unsigned char* edge = std::lower_bound(edgesBegin, edgesEnd, byte);
+    if (edge != edgesEnd && *edge == byte) {
+      return automaton.edgeTargets[edge - automaton.edgeBytes.data()];
+    }
+    state = current.failure;
   }
+  return automaton.rootTransitions[byte];
+}
 
-  const std::string_view left = TrimAsciiWhitespace(trimmedLine.substr(0, tsFieldPos));
-  const std::string_view right = TrimAsciiWhitespace(trimmedLine.substr(tsFieldEnd));
-  if (left.empty()) {
-    return std::string(right);
+// Per-thread counters for FindMatchingIgnoreRule. An entry counts only if its stamp is the current
+// one, so nothing has to be cleared between lines.
+struct IgnoreMatchScratch {
+  std::vector<UINT> termStamps;
+  std::vector<UINT> ruleStamps;
+  std::vector<UINT> ruleTermHits;
+  std::vector<UINT> patternCandidates;
+  std::string fieldValue;
+  UINT stamp = 0;
+};
+
+bool IgnorePatternTermMatches(
+    const IgnorePatternTerm& patternTerm,
+    std::string_view rawLine,
+    const AlertFieldSpans& fields,
+    std::string* scratch) {
+  if (!patternTerm.fieldScoped) {
+    return IgnorePatternMatches(*patternTerm.pattern, rawLine);
   }
-  if (right.empty()) {
-    return std::string(left);
+  const AlertFieldSpan span = IgnoreFieldSpan(fields, patternTerm.field);
+  return span.end > span.begin && IgnorePatternMatches(*patternTerm.pattern, AlertFieldValue(rawLine, span, scratch));
+}
+
+// Field parts are looked up by the line's field values, then one automaton pass finds the substring
+// parts. Every term seen for the first time bumps the hit count of the rules that require it, and a
+// rule matches once all its distinct terms were seen. Rules with pattern parts only become candidates
+// that way; their patterns run afterwards, and only for rules ahead of the best plain match. The
+// first matching rule in list order wins, as it did when the rules were tried one by one. fields are
+// spans into rawLine. When cost is given, the time spent is added to it.
+const IgnoreRule* FindMatchingIgnoreRule(
+    const IgnoreRuleSet& ruleSet,
+    std::string_view rawLine,
+    const AlertFieldSpans& fields,
+    IgnoreMatchCost* cost) {
+  if (ruleSet.rules.empty()) {
+    return nullptr;
   }
+  const ULONGLONG startTicks = cost ? PerformanceCounterTicks() : 0;
 
-  return std::string(left) + " && " + std::string(right);
+  thread_local IgnoreMatchScratch scratch;
+  const size_t termCount = ruleSet.termRuleBegins.size() - 1;
+  if (scratch.termStamps.size() < termCount) {
+    scratch.termStamps.resize(termCount, 0);
+  }
+  if (scratch.ruleStamps.size() < ruleSet.rules.size()) {
+    scratch.ruleStamps.resize(ruleSet.rules.size(), 0);
+    scratch.ruleTermHits.resize(ruleSet.rules.size(), 0);
+  }
+  if (++scratch.stamp == 0) {
+    std::fill(scratch.termStamps.begin(), scratch.termStamps.end(), 0);
+    std::fill(scratch.ruleStamps.begin(), scratch.ruleStamps.end(), 0);
+    scratch.stamp = 1;
+  }
+  const UINT stamp = scratch.stamp;
+
+  UINT matchedRuleId = kNoIgnoreRule;
+  scratch.patternCandidates.assign(ruleSet.patternOnlyRuleIds.begin(), ruleSet.patternOnlyRuleIds.end());
+  const auto countTerm = [&ruleSet, stamp, &matchedRuleId](UINT term) {
+    if (scratch.termStamps[term] == stamp) {
+      return false;
+    }
+    scratch.termStamps[term] = stamp;
+    for (UINT i = ruleSet.termRuleBegins[term]; i < ruleSet.termRuleBegins[term + 1]; ++i) {
+      const UINT ruleId = ruleSet.termRuleIds[i];
+      if (scratch.ruleStamps[ruleId] != stamp) {
+        scratch.ruleStamps[ruleId] = stamp;
+        scratch.ruleTermHits[ruleId] = 0;
+      }
+      if (++scratch.ruleTermHits[ruleId] != ruleSet.ruleTermCounts[ruleId]) {
+        continue;
+      }
+      if (ruleSet.rules[ruleId].patternTerms.empty()) {
+        matchedRuleId = (std::min)(matchedRuleId, ruleId);
+      } else {
+        scratch.patternCandidates.push_back(ruleId);
+      }
+    }
+    return true;
+  };
+
+  for (const IgnoreFieldName& fieldName : kIgnoreFieldNames) {
+    const auto& valueTermIds = ruleSet.fieldValueTermIds[static_cast<size_t>(fieldName.field)];
+    const AlertFieldSpan span = IgnoreFieldSpan(fields, fieldName.field);
+    if (valueTermIds.empty() || span.end <= span.begin) {
+      continue;
+    }
+    const auto it = valueTermIds.find(AlertFieldValue(rawLine, span, &scratch.fieldValue));
+    if (it != valueTermIds.end()) {
+      countTerm(it->second);
+    }
+  }
+
+  const IgnoreTermAutomaton& automaton = ruleSet.automaton;
+  if (automaton.states.size() > 1) {
+    UINT state = 0;
+    for (const char ch : rawLine) {
+      state = NextIgnoreTermState(automaton, state, static_cast<unsigned char>(ch));
+      UINT output = (automaton.states[state].term != kNoIgnoreTerm) ? state : automaton.states[state].outputLink;
+      // The rest of the chain are suffixes of a term already seen, so they were counted along with it.
+      while (output != kNoIgnoreTermState && countTerm(automaton.states[output].term)) {
+        output = automaton.states[output].outputLink;
+      }
+    }
+  }
+
+  std::sort(scratch.patternCandidates.begin(), scratch.patternCandidates.end());
+  if (cost && cost->ruleTicks.size() < ruleSet.rules.size()) {
+    cost->ruleTicks.resize(ruleSet.rules.size(), 0);
+  }
+  for (const UINT ruleId : scratch.patternCandidates) {
+    if (ruleId >= matchedRuleId) {
+      break;
+    }
+    const ULONGLONG ruleStartTicks = cost ? PerformanceCounterTicks() : 0;
+    const std::vector<IgnorePatternTerm>& patternTerms = ruleSet.rules[ruleId].patternTerms;
+    const bool allMatch = std::all_of(
+        patternTerms.begin(),
+        patternTerms.end(),
+        [rawLine, &fields](const IgnorePatternTerm& patternTerm) {
+          return IgnorePatternTermMatches(patternTerm, rawLine, fields, &scratch.fieldValue);
+        });
+    if (cost) {
+      cost->ruleTicks[ruleId] += PerformanceCounterTicks() - ruleStartTicks;
+    }
+    if (allMatch) {
+      matchedRuleId = ruleId;
+      break;
+    }
+  }
+  if (cost) {
+    cost->totalTicks += PerformanceCounterTicks() - startTicks;
+    ++cost->lineCount;
+  }
+  return (matchedRuleId == kNoIgnoreRule) ? nullptr : &ruleSet.rules[matchedRuleId];
+}
+
+void AddIgnoreMatchCost(const IgnoreMatchCost& cost, IgnoreMatchCost* total) {
+  if (total->ruleTicks.size() < cost.ruleTicks.size()) {
+    total->ruleTicks.resize(cost.ruleTicks.size(), 0);
+  }
+  for (size_t i = 0; i < cost.ruleTicks.size(); ++i) {
+    total->ruleTicks[i] += cost.ruleTicks[i];
+  }
+  total->totalTicks += cost.totalTicks;
+  total->lineCount += cost.lineCount;
 }
 
 AlertSeverity MaxAlertSeverity(AlertSeverity left, AlertSeverity right) {
@@ -1222,22 +4070,22 @@ bool ShouldBlinkForSeverity(AlertSeverity severity) {
   return severity == AlertSeverity::kError;
 }
 
+// The first level value in the line decides; lines below the configured minimum are rejected before
+// the logger key is even looked for.
 AlertSeverity AlertSeverityFromLine(std::string_view line) {
-  if (line.find(kAlertKeyword) == std::string_view::npos) {
+  const size_t levelPos = line.find(kLevelKeyPrefix);
+  if (levelPos == std::string_view::npos) {
     return AlertSeverity::kNone;
   }
-  if (line.find(kErrorLevelKeyword) != std::string_view::npos ||
-      line.find(kDPanicLevelKeyword) != std::string_view::npos ||
-      line.find(kPanicLevelKeyword) != std::string_view::npos ||
-      line.find(kFatalLevelKeyword) != std::string_view::npos) {
-    return AlertSeverity::kError;
-  }
-  if (line.find(kWarnLevelKeyword) != std::string_view::npos) {
-    return AlertSeverity::kWarning;
+  const AlertSeverity severity = LevelSeverityAt(line, levelPos);
+  if (!IsAtLeastMinimumAlertSeverity(severity) || line.find(kAlertKeyword) == std::string_view::npos) {
+    return AlertSeverity::kNone;
   }
-  return AlertSeverity::kWarning;
+  return severity;
 }
 
+// Fills in the severity and field spans; the spans are relative to line. rawLine is left empty, the
+// caller copies the text only if it keeps the entry.
 bool TryBuildAlertEntryFromLine(std::string_view line, AlertEntry* outEntry) {
   if (!outEntry) {
     return false;
@@ -1248,43 +4096,226 @@ bool TryBuildAlertEntryFromLine(std::string_view line, AlertEntry* outEntry) {
     return false;
   }
 
-  std::string loggerText;
-  std::string messageText;
-  std::string itemText;
-  std::string errorMessageText;
-  ExtractJsonStringField(line, "logger", &loggerText);
-  ExtractJsonStringField(line, "msg", &messageText);
-  ExtractJsonStringField(line, "item", &itemText);
-  ExtractErrorMessageField(line, &errorMessageText);
-
-  const std::wstring rawLineText = Utf8ToWide(line);
-  const std::wstring loggerWide = Utf8ToWide(loggerText);
-  const std::wstring messageWide = Utf8ToWide(messageText);
-  const std::wstring itemWide = Utf8ToWide(itemText);
-  const std::wstring errorMessageWide = Utf8ToWide(errorMessageText);
+  // Reused per thread so that building an entry allocates nothing once the vectors have grown.
+  thread_local JsonLineFields fields;
+  const std::string_view trimmedLine = TrimAsciiWhitespace(line);
+  TokenizeJsonLogLine(trimmedLine, &fields);
+  const size_t trimmedOffset = static_cast<size_t>(trimmedLine.data() - line.data());
+  const auto stringValueSpan = [trimmedOffset](const JsonFieldSpan* field) {
+    AlertFieldSpan span = {};
+    if (field && fields.line[field->valueBegin] == '"') {
+      span.begin = static_cast<UINT>(trimmedOffset + field->valueBegin);
+      span.end = static_cast<UINT>(trimmedOffset + field->valueEnd);
+    }
+    return span;
+  };
 
   AlertEntry entry = {};
   entry.severity = severity;
-  entry.rawLine = std::string(line);
-  entry.ignoreRuleText = BuildSuggestedIgnoreRuleText(line);
-  entry.summaryText = FormatAlertSummaryText(severity, loggerWide, messageWide, rawLineText);
-  entry.itemText = itemWide;
-  entry.errorMessageText = errorMessageWide;
+  entry.fields.logger = stringValueSpan(FindJsonField(fields.topLevel, "logger"));
+  entry.fields.message = stringValueSpan(FindJsonField(fields.topLevel, "msg"));
+  entry.fields.item = stringValueSpan(FindJsonField(fields.topLevel, "item"));
+  entry.fields.errorMessage = stringValueSpan(FindJsonField(fields.error, "message"));
+  if (const JsonFieldSpan* tsField = FindJsonField(fields.topLevel, "ts")) {
+    entry.fields.tsMember.begin = static_cast<UINT>(trimmedOffset + tsField->memberBegin);
+    entry.fields.tsMember.end = static_cast<UINT>(trimmedOffset + tsField->valueEnd);
+  }
   *outEntry = std::move(entry);
   return true;
 }
 
-bool IsAlertIgnored(std::string_view rawLine) {
-  return FindMatchingIgnoreRule(rawLine) != nullptr;
+struct LineScanState {
+  ULONGLONG currentLineNumber = 0;
+  AlertSeverity highestSeverity = AlertSeverity::kNone;
+  std::vector<AlertEntry>* outEntries = nullptr;
+  LineCheckpointIndex* lineIndex = nullptr;
+  IgnoreMatchCost* ignoreMatchCost = nullptr;
+};
+
+void ScanAlertCandidateLine(std::string_view line, ULONGLONG lineOffset, LineScanState* state) {
+  if (!line.empty() && line.back() == '\r') {
+    line.remove_suffix(1);
+  }
+
+  ++state->currentLineNumber;
+  AppendAlertEntryIfNeeded(
+      line,
+      state->currentLineNumber,
+      lineOffset,
+      &state->highestSeverity,
+      state->outEntries,
+      state->ignoreMatchCost);
 }
 
-AlertSeverity ScanFileRangeForAlertEntries(
+void ScanLine(std::string_view line, ULONGLONG lineOffset, LineScanState* state) {
+  if (FindAlertLevelToken(line, 0) == std::string_view::npos) {
+    ++state->currentLineNumber;
+    return;
+  }
+  ScanAlertCandidateLine(line, lineOffset, state);
+}
+
+// The unterminated last line of a range is reported under the number it will have once finished,
+// but it is not counted: a later scan resuming at the end of the range continues that same line.
+void ScanUnterminatedLine(std::string_view line, ULONGLONG lineOffset, LineScanState* state) {
+  ScanLine(line, lineOffset, state);
+  --state->currentLineNumber;
+}
+
+// Scans every '\n'-terminated line in data and returns how many bytes were consumed,
+// i.e. the position just past the last newline. A trailing partial line is left alone.
+// Lines are not split one by one: the level-token kernel jumps straight to the next alert
+// candidate and the newlines skipped on the way are only counted.
+size_t ScanCompleteLines(std::string_view data, ULONGLONG dataOffset, LineScanState* state) {
+  const size_t lastNewline = data.rfind('\n');
+  if (lastNewline == std::string_view::npos) {
+    return 0;
+  }
+
+  const std::string_view completeLines = data.substr(0, lastNewline + 1);
+  size_t lineStart = 0;
+  while (lineStart < completeLines.size()) {
+    const size_t tokenPos = FindAlertLevelToken(completeLines, lineStart);
+    if (tokenPos == std::string_view::npos) {
+      break;
+    }
+
+    const size_t previousNewline = completeLines.rfind('\n', tokenPos);
+    const size_t candidateStart = (previousNewline == std::string_view::npos) ? 0 : previousNewline + 1;
+    const size_t candidateEnd = completeLines.find('\n', tokenPos);
+    AdvanceNewlineCount(
+        completeLines.substr(lineStart, candidateStart - lineStart),
+        dataOffset + lineStart,
+        &state->currentLineNumber,
+        state->lineIndex);
+    ScanAlertCandidateLine(
+        completeLines.substr(candidateStart, candidateEnd - candidateStart),
+        dataOffset + candidateStart,
+        state);
+    lineStart = candidateEnd + 1;
+  }
+
+  AdvanceNewlineCount(
+      completeLines.substr(lineStart),
+      dataOffset + lineStart,
+      &state->currentLineNumber,
+      state->lineIndex);
+  return completeLines.size();
+}
+
+ULONGLONG MappingAllocationGranularity() {
+  static ULONGLONG granularity = 0;
+  if (granularity == 0) {
+    SYSTEM_INFO systemInfo = {};
+    GetSystemInfo(&systemInfo);
+    granularity = (systemInfo.dwAllocationGranularity != 0) ? systemInfo.dwAllocationGranularity : 64 * 1024;
+  }
+  return granularity;
+}
+
+// Scans [beginOffset, endOffset) through read-only views of the file so lines are handed out as
+// string_views straight into the mapping. At most kMappedScanWindowBytes are mapped at a time; the
+// window slides forward to the start of the first unfinished line. Returns false when the file cannot
+// be mapped, with *outScannedOffset set to the first byte that still needs scanning.
+bool ScanMappedFileRange(
+    HANDLE file,
+    ULONGLONG beginOffset,
+    ULONGLONG endOffset,
+    LineScanState* state,
+    ULONGLONG* outScannedOffset) {
+  *outScannedOffset = beginOffset;
+
+  ULARGE_INTEGER mappingSize = {};
+  mappingSize.QuadPart = endOffset;
+  HANDLE mapping = CreateFileMappingW(
+      file,
+      nullptr,
+      PAGE_READONLY,
+      mappingSize.HighPart,
+      mappingSize.LowPart,
+      nullptr);
+  if (!mapping) {
+    return false;
+  }
+
+  const ULONGLONG granularity = MappingAllocationGranularity();
+  ULONGLONG position = beginOffset;
+  std::string overlongLine;
+  ULONGLONG overlongLineOffset = 0;
+  bool mappedWholeRange = true;
+  while (position < endOffset) {
+    const ULONGLONG viewBegin = position - (position % granularity);
+    const ULONGLONG viewEnd = (std::min)(endOffset, viewBegin + kMappedScanWindowBytes);
+    ULARGE_INTEGER viewOffset = {};
+    viewOffset.QuadPart = viewBegin;
+    const char* view = static_cast<const char*>(MapViewOfFile(
+        mapping,
+        FILE_MAP_READ,
+        viewOffset.HighPart,
+        viewOffset.LowPart,
+        static_cast<SIZE_T>(viewEnd - viewBegin)));
+    if (!view) {
+      mappedWholeRange = false;
+      break;
+    }
+
+    std::string_view data(view + (position - viewBegin), static_cast<size_t>(viewEnd - position));
+    if (!overlongLine.empty()) {
+      const size_t lineEnd = data.find('\n');
+      if (lineEnd == std::string_view::npos) {
+        overlongLine.append(data);
+        data = {};
+      } else {
+        overlongLine.append(data.data(), lineEnd);
+        ScanLine(overlongLine, overlongLineOffset, state);
+        overlongLine.clear();
+        data.remove_prefix(lineEnd + 1);
+      }
+    }
+
+    data.remove_prefix(ScanCompleteLines(data, viewEnd - data.size(), state));
+    const ULONGLONG unfinishedLineOffset = viewEnd - data.size();
+    if (viewEnd == endOffset) {
+      if (!data.empty()) {
+        ScanUnterminatedLine(data, unfinishedLineOffset, state);
+      }
+      position = endOffset;
+    } else if (unfinishedLineOffset - (unfinishedLineOffset % granularity) == viewBegin) {
+      // Sliding would map the same window again: the line is longer than the window, so copy it out.
+      if (overlongLine.empty()) {
+        overlongLineOffset = unfinishedLineOffset;
+      }
+      overlongLine.append(data);
+      position = viewEnd;
+    } else {
+      position = unfinishedLineOffset;
+    }
+
+    UnmapViewOfFile(view);
+  }
+
+  CloseHandle(mapping);
+  if (!mappedWholeRange) {
+    *outScannedOffset = position - overlongLine.size();
+    return false;
+  }
+
+  if (!overlongLine.empty()) {
+    ScanUnterminatedLine(overlongLine, overlongLineOffset, state);
+  }
+  *outScannedOffset = endOffset;
+  return true;
+}
+
+AlertSeverity ScanFileRangeOnCurrentThread(
     HANDLE file,
     ULONGLONG beginOffset,
     ULONGLONG endOffset,
     ULONGLONG startingLineNumber,
     ULONGLONG* outEndingLineNumber,
-    std::vector<AlertEntry>* outEntries) {
+    std::vector<AlertEntry>* outEntries,
+    LineCheckpointIndex* lineIndex,
+    IgnoreMatchCost* ignoreMatchCost) {
   if (endOffset <= beginOffset) {
     if (outEndingLineNumber) {
       *outEndingLineNumber = startingLineNumber;
@@ -1292,71 +4323,415 @@ AlertSeverity ScanFileRangeForAlertEntries(
     return AlertSeverity::kNone;
   }
 
+  LineScanState state = {};
+  state.currentLineNumber = startingLineNumber;
+  state.outEntries = outEntries;
+  state.lineIndex = lineIndex;
+  state.ignoreMatchCost = ignoreMatchCost;
+
+  ULONGLONG scannedOffset = beginOffset;
+  if (endOffset - beginOffset >= kMinMappedScanBytes) {
+    if (ScanMappedFileRange(file, beginOffset, endOffset, &state, &scannedOffset)) {
+      if (outEndingLineNumber) {
+        *outEndingLineNumber = state.currentLineNumber;
+      }
+      return state.highestSeverity;
+    }
+    DebugLog(
+        L"Mapped scan unavailable, falling back to ReadFile at offset " + std::to_wstring(scannedOffset) +
+        L". error=" + std::to_wstring(GetLastError()));
+  }
+
   LARGE_INTEGER filePointer = {};
-  filePointer.QuadPart = static_cast<LONGLONG>(beginOffset);
+  filePointer.QuadPart = static_cast<LONGLONG>(scannedOffset);
   if (!SetFilePointerEx(file, filePointer, nullptr, FILE_BEGIN)) {
-    return AlertSeverity::kNone;
+    return state.highestSeverity;
   }
 
   constexpr DWORD kBufferSize = 64 * 1024;
   char buffer[kBufferSize];
   std::string pendingLine;
-  AlertSeverity highestSeverity = AlertSeverity::kNone;
-  ULONGLONG currentLineNumber = startingLineNumber;
+  ULONGLONG pendingLineOffset = 0;
 
-  ULONGLONG remaining = endOffset - beginOffset;
+  ULONGLONG position = scannedOffset;
+  ULONGLONG remaining = endOffset - scannedOffset;
   while (remaining > 0) {
     const DWORD toRead = static_cast<DWORD>(
-        std::min<ULONGLONG>(remaining, static_cast<ULONGLONG>(kBufferSize)));
+        std::min<ULONGLONG>(remaining, static_cast<ULONGLONG>(kBufferSize)));
+    DWORD bytesRead = 0;
+    if (!ReadFile(file, buffer, toRead, &bytesRead, nullptr)) {
+      return state.highestSeverity;
+    }
+    if (bytesRead == 0) {
+      break;
+    }
+
+    // Only the line straddling two reads is copied; everything else is scanned in place.
+    std::string_view data(buffer, bytesRead);
+    if (!pendingLine.empty()) {
+      const size_t lineEnd = data.find('\n');
+      if (lineEnd == std::string_view::npos) {
+        pendingLine.append(data);
+        data = {};
+      } else {
+        pendingLine.append(data.data(), lineEnd);
+        ScanLine(pendingLine, pendingLineOffset, &state);
+        pendingLine.clear();
+        data.remove_prefix(lineEnd + 1);
+      }
+    }
+
+    data.remove_prefix(ScanCompleteLines(data, position + bytesRead - data.size(), &state));
+    if (pendingLine.empty()) {
+      pendingLineOffset = position + bytesRead - data.size();
+    }
+    pendingLine.append(data);
+
+    position += bytesRead;
+    remaining -= bytesRead;
+  }
+
+  if (!pendingLine.empty()) {
+    ScanUnterminatedLine(pendingLine, pendingLineOffset, &state);
+  }
+
+  if (outEndingLineNumber) {
+    *outEndingLineNumber = state.currentLineNumber;
+  }
+
+  return state.highestSeverity;
+}
+
+// A chunk owns the lines that start inside [beginOffset, endOffset). Its line numbers, newline count
+// and checkpoints are relative to beginOffset until the chunks are merged in file order.
+struct ParallelScanChunk {
+  ULONGLONG beginOffset = 0;
+  ULONGLONG endOffset = 0;
+  ULONGLONG newlineCount = 0;
+  AlertSeverity highestSeverity = AlertSeverity::kNone;
+  std::vector<AlertEntry> entries;
+  LineCheckpointIndex lineIndex;
+  IgnoreMatchCost ignoreMatchCost;
+  bool completed = false;
+};
+
+struct ParallelScanContext {
+  HANDLE file = INVALID_HANDLE_VALUE;
+  ULONGLONG fileGeneration = 0;
+  std::vector<ParallelScanChunk> chunks;
+  std::atomic<size_t> nextChunk{0};
+};
+
+// file is the worker's own file object for the log, so the ReadFile fallback does not race other
+// workers on the file pointer. It is reopened only when a job names another file.
+struct ParallelScanWorker {
+  HANDLE thread = nullptr;
+  HANDLE startEvent = nullptr;
+  HANDLE doneEvent = nullptr;
+  HANDLE file = INVALID_HANDLE_VALUE;
+  HANDLE sourceFile = INVALID_HANDLE_VALUE;
+  ULONGLONG sourceFileGeneration = 0;
+};
+
+// Started by the scanner thread on its first parallel scan and kept until it shuts down, so catching
+// up on a large backlog does not start threads for every slice. job is set while the workers run one;
+// a start signal without a job tells them to exit.
+struct ParallelScanPool {
+  std::vector<std::unique_ptr<ParallelScanWorker>> workers;
+  ParallelScanContext* job = nullptr;
+  bool started = false;
+};
+
+ParallelScanPool g_scanPool;
+
+DWORD ParallelScanWorkerCount() {
+  SYSTEM_INFO systemInfo = {};
+  GetSystemInfo(&systemInfo);
+  return (std::min<DWORD>)(systemInfo.dwNumberOfProcessors, MAXIMUM_WAIT_OBJECTS);
+}
+
+void ScanParallelScanChunk(HANDLE file, ParallelScanChunk* chunk) {
+  chunk->lineIndex.checkpoints.push_back({chunk->beginOffset, 0});
+  chunk->highestSeverity = ScanFileRangeOnCurrentThread(
+      file,
+      chunk->beginOffset,
+      chunk->endOffset,
+      0,
+      &chunk->newlineCount,
+      &chunk->entries,
+      &chunk->lineIndex,
+      &chunk->ignoreMatchCost);
+  chunk->completed = true;
+}
+
+DWORD WINAPI ParallelScanWorkerProc(LPVOID parameter) {
+  auto* worker = static_cast<ParallelScanWorker*>(parameter);
+  for (;;) {
+    WaitForSingleObject(worker->startEvent, INFINITE);
+    ParallelScanContext* context = g_scanPool.job;
+    if (!context) {
+      break;
+    }
+
+    if (worker->sourceFile != context->file || worker->sourceFileGeneration != context->fileGeneration) {
+      if (worker->file != INVALID_HANDLE_VALUE) {
+        CloseHandle(worker->file);
+      }
+      worker->file =
+          ReOpenFile(context->file, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, 0);
+      worker->sourceFile = (worker->file != INVALID_HANDLE_VALUE) ? context->file : INVALID_HANDLE_VALUE;
+      worker->sourceFileGeneration = context->fileGeneration;
+    }
+    // Chunks a worker could not take are scanned by the caller while merging.
+    while (worker->file != INVALID_HANDLE_VALUE) {
+      const size_t chunkIndex = context->nextChunk.fetch_add(1);
+      if (chunkIndex >= context->chunks.size()) {
+        break;
+      }
+      ScanParallelScanChunk(worker->file, &context->chunks[chunkIndex]);
+    }
+    SetEvent(worker->doneEvent);
+  }
+
+  if (worker->file != INVALID_HANDLE_VALUE) {
+    CloseHandle(worker->file);
+  }
+  return 0;
+}
+
+void CloseParallelScanWorkerEvents(ParallelScanWorker* worker) {
+  if (worker->startEvent) {
+    CloseHandle(worker->startEvent);
+  }
+  if (worker->doneEvent) {
+    CloseHandle(worker->doneEvent);
+  }
+}
+
+void StartParallelScanPool(DWORD workerCount) {
+  g_scanPool.started = true;
+  for (DWORD i = 0; i < workerCount; ++i) {
+    auto worker = std::make_unique<ParallelScanWorker>();
+    worker->startEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    worker->doneEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    if (worker->startEvent && worker->doneEvent) {
+      worker->thread = CreateThread(nullptr, 0, ParallelScanWorkerProc, worker.get(), 0, nullptr);
+    }
+    if (!worker->thread) {
+      CloseParallelScanWorkerEvents(worker.get());
+      break;
+    }
+    g_scanPool.workers.push_back(std::move(worker));
+  }
+  DebugLog(L"Parallel scan pool started. workers=" + std::to_wstring(g_scanPool.workers.size()));
+}
+
+void StopParallelScanPool() {
+  if (!g_scanPool.started) {
+    return;
+  }
+  g_scanPool.job = nullptr;
+  std::vector<HANDLE> threads;
+  for (const std::unique_ptr<ParallelScanWorker>& worker : g_scanPool.workers) {
+    SetEvent(worker->startEvent);
+    threads.push_back(worker->thread);
+  }
+  if (!threads.empty()) {
+    WaitForMultipleObjects(static_cast<DWORD>(threads.size()), threads.data(), TRUE, INFINITE);
+  }
+  for (const std::unique_ptr<ParallelScanWorker>& worker : g_scanPool.workers) {
+    CloseHandle(worker->thread);
+    CloseParallelScanWorkerEvents(worker.get());
+  }
+  g_scanPool.workers.clear();
+  g_scanPool.started = false;
+}
+
+// Runs context on the pool and returns once every worker is done with it.
+void RunParallelScanJob(ParallelScanContext* context) {
+  if (!g_scanPool.started) {
+    StartParallelScanPool(ParallelScanWorkerCount());
+  }
+  g_scanPool.job = context;
+  std::vector<HANDLE> doneEvents;
+  for (const std::unique_ptr<ParallelScanWorker>& worker : g_scanPool.workers) {
+    SetEvent(worker->startEvent);
+    doneEvents.push_back(worker->doneEvent);
+  }
+  if (!doneEvents.empty()) {
+    WaitForMultipleObjects(static_cast<DWORD>(doneEvents.size()), doneEvents.data(), TRUE, INFINITE);
+  }
+  g_scanPool.job = nullptr;
+}
+
+// First offset in [offset, endOffset) that starts a line, or endOffset.
+ULONGLONG LineStartAtOrAfter(HANDLE file, ULONGLONG offset, ULONGLONG endOffset) {
+  LARGE_INTEGER filePointer = {};
+  filePointer.QuadPart = static_cast<LONGLONG>(offset - 1);
+  if (!SetFilePointerEx(file, filePointer, nullptr, FILE_BEGIN)) {
+    return endOffset;
+  }
+
+  constexpr DWORD kBufferSize = 4 * 1024;
+  char buffer[kBufferSize];
+  ULONGLONG position = offset - 1;
+  while (position < endOffset) {
+    const DWORD toRead = static_cast<DWORD>(
+        std::min<ULONGLONG>(endOffset - position, static_cast<ULONGLONG>(kBufferSize)));
+    DWORD bytesRead = 0;
+    if (!ReadFile(file, buffer, toRead, &bytesRead, nullptr) || bytesRead == 0) {
+      break;
+    }
+    const std::string_view data(buffer, bytesRead);
+    const size_t newline = data.find('\n');
+    if (newline != std::string_view::npos) {
+      return (std::min)(position + newline + 1, endOffset);
+    }
+    position += bytesRead;
+  }
+  return endOffset;
+}
+
+// Offset just past the last '\n' in [beginOffset, endOffset), or beginOffset when the range holds none.
+ULONGLONG LineStartAfterLastNewline(HANDLE file, ULONGLONG beginOffset, ULONGLONG endOffset) {
+  constexpr DWORD kBufferSize = 4 * 1024;
+  char buffer[kBufferSize];
+  ULONGLONG position = endOffset;
+  while (position > beginOffset) {
+    const DWORD toRead = static_cast<DWORD>(
+        std::min<ULONGLONG>(position - beginOffset, static_cast<ULONGLONG>(kBufferSize)));
+    LARGE_INTEGER filePointer = {};
+    filePointer.QuadPart = static_cast<LONGLONG>(position - toRead);
     DWORD bytesRead = 0;
-    if (!ReadFile(file, buffer, toRead, &bytesRead, nullptr)) {
-      return highestSeverity;
+    if (!SetFilePointerEx(file, filePointer, nullptr, FILE_BEGIN) ||
+        !ReadFile(file, buffer, toRead, &bytesRead, nullptr) ||
+        bytesRead != toRead) {
+      return beginOffset;
     }
-    if (bytesRead == 0) {
-      break;
+    const std::string_view data(buffer, bytesRead);
+    const size_t newline = data.rfind('\n');
+    if (newline != std::string_view::npos) {
+      return position - toRead + newline + 1;
     }
+    position -= toRead;
+  }
+  return beginOffset;
+}
 
-    pendingLine.append(buffer, bytesRead);
-
-    size_t lineStart = 0;
-    while (lineStart < pendingLine.size()) {
-      const size_t lineEnd = pendingLine.find('\n', lineStart);
-      if (lineEnd == std::string::npos) {
-        break;
-      }
+// Splits a large range into newline-aligned chunks and classifies them on one worker per core. The
+// results are merged in file order, so entries, line numbers and checkpoints come out exactly as a
+// single sequential pass would produce them. Returns false when the range is not worth splitting.
+bool TryScanFileRangeInParallel(
+    HANDLE file,
+    ULONGLONG beginOffset,
+    ULONGLONG endOffset,
+    ULONGLONG startingLineNumber,
+    ULONGLONG* outEndingLineNumber,
+    std::vector<AlertEntry>* outEntries,
+    LineCheckpointIndex* lineIndex,
+    IgnoreMatchCost* ignoreMatchCost,
+    AlertSeverity* outHighestSeverity) {
+  const DWORD processorCount = ParallelScanWorkerCount();
+  const ULONGLONG rangeBytes = endOffset - beginOffset;
+  if (processorCount < 2 || rangeBytes < 2 * kMinParallelScanChunkBytes) {
+    return false;
+  }
 
-      std::string_view line(pendingLine.data() + lineStart, lineEnd - lineStart);
-      if (!line.empty() && line.back() == '\r') {
-        line.remove_suffix(1);
-      }
+  // Starting a job on the pool is cheap, so chunks stay small enough that a slice capped by
+  // scan_budget_mb still gives every worker several of them.
+  const ULONGLONG chunkBytes = (std::max)(
+      kMinParallelScanChunkBytes,
+      rangeBytes / (static_cast<ULONGLONG>(processorCount) * kParallelScanChunksPerWorker) + 1);
+  ParallelScanContext context;
+  context.file = file;
+  context.fileGeneration = g_scanner.logFileGeneration;
+  ULONGLONG chunkBegin = beginOffset;
+  while (chunkBegin < endOffset) {
+    const ULONGLONG chunkEnd = endOffset - chunkBegin <= chunkBytes
+                                   ? endOffset
+                                   : LineStartAtOrAfter(file, chunkBegin + chunkBytes, endOffset);
+    ParallelScanChunk chunk = {};
+    chunk.beginOffset = chunkBegin;
+    chunk.endOffset = chunkEnd;
+    context.chunks.push_back(std::move(chunk));
+    chunkBegin = chunkEnd;
+  }
+  if (context.chunks.size() < 2) {
+    return false;
+  }
 
-      ++currentLineNumber;
-      AppendAlertEntryIfNeeded(line, currentLineNumber, &highestSeverity, outEntries);
+  RunParallelScanJob(&context);
+  DebugLog(
+      L"Parallel scan finished. chunks=" + std::to_wstring(context.chunks.size()) +
+      L", workers=" + std::to_wstring(g_scanPool.workers.size()));
 
-      lineStart = lineEnd + 1;
+  AlertSeverity highestSeverity = AlertSeverity::kNone;
+  ULONGLONG lineNumberBase = startingLineNumber;
+  for (ParallelScanChunk& chunk : context.chunks) {
+    if (!chunk.completed) {
+      ScanParallelScanChunk(file, &chunk);
     }
 
-    if (lineStart > 0) {
-      pendingLine.erase(0, lineStart);
+    for (AlertEntry& entry : chunk.entries) {
+      entry.lineNumber += lineNumberBase;
+      if (outEntries) {
+        outEntries->push_back(std::move(entry));
+      }
     }
-
-    remaining -= bytesRead;
-  }
-
-  if (!pendingLine.empty()) {
-    std::string_view line(pendingLine);
-    if (!line.empty() && line.back() == '\r') {
-      line.remove_suffix(1);
+    if (lineIndex) {
+      for (const LineCheckpoint& checkpoint : chunk.lineIndex.checkpoints) {
+        if (lineIndex->checkpoints.empty() || checkpoint.offset > lineIndex->checkpoints.back().offset) {
+          lineIndex->checkpoints.push_back({checkpoint.offset, checkpoint.newlineCount + lineNumberBase});
+          lineIndex->dirty = true;
+        }
+      }
     }
-    ++currentLineNumber;
-    AppendAlertEntryIfNeeded(line, currentLineNumber, &highestSeverity, outEntries);
+    if (ignoreMatchCost) {
+      AddIgnoreMatchCost(chunk.ignoreMatchCost, ignoreMatchCost);
+    }
+    highestSeverity = MaxAlertSeverity(highestSeverity, chunk.highestSeverity);
+    lineNumberBase += chunk.newlineCount;
   }
 
   if (outEndingLineNumber) {
-    *outEndingLineNumber = currentLineNumber;
+    *outEndingLineNumber = lineNumberBase;
   }
+  *outHighestSeverity = highestSeverity;
+  return true;
+}
 
-  return highestSeverity;
+AlertSeverity ScanFileRangeForAlertEntries(
+    HANDLE file,
+    ULONGLONG beginOffset,
+    ULONGLONG endOffset,
+    ULONGLONG startingLineNumber,
+    ULONGLONG* outEndingLineNumber,
+    std::vector<AlertEntry>* outEntries,
+    LineCheckpointIndex* lineIndex,
+    IgnoreMatchCost* ignoreMatchCost) {
+  AlertSeverity highestSeverity = AlertSeverity::kNone;
+  if (endOffset > beginOffset &&
+      TryScanFileRangeInParallel(
+          file,
+          beginOffset,
+          endOffset,
+          startingLineNumber,
+          outEndingLineNumber,
+          outEntries,
+          lineIndex,
+          ignoreMatchCost,
+          &highestSeverity)) {
+    return highestSeverity;
+  }
+  return ScanFileRangeOnCurrentThread(
+      file,
+      beginOffset,
+      endOffset,
+      startingLineNumber,
+      outEndingLineNumber,
+      outEntries,
+      lineIndex,
+      ignoreMatchCost);
 }
 
 void SaveLogPathToConfig(const std::wstring& logPath) {
@@ -1536,6 +4911,81 @@ void LoadAcknowledgedOffsetFromConfig() {
   }
 }
 
+UINT LoadUintFromConfigOrDefault(const wchar_t* key, UINT defaultValue) {
+  constexpr UINT kUnsetValue = (std::numeric_limits<UINT>::max)();
+  const UINT configuredValue = GetPrivateProfileIntW(L"watcher", key, kUnsetValue, g_state.configPath.c_str());
+  if (configuredValue != kUnsetValue) {
+    return configuredValue;
+  }
+  wchar_t valueBuffer[32] = {};
+  StringCchPrintfW(valueBuffer, ARRAYSIZE(valueBuffer), L"%u", defaultValue);
+  WritePrivateProfileStringW(L"watcher", key, valueBuffer, g_state.configPath.c_str());
+  return defaultValue;
+}
+
+// scan_budget_mb bounds how much of a backlog the scanner classifies before it looks at its command
+// queue and reports progress again; 0 scans any backlog in one go. scan_budget_ms additionally bounds
+// the time a slice should take, converted to bytes at the throughput earlier slices reached (see
+// ScanSliceBytes); 0 leaves only the byte budget.
+void LoadScanBudgetFromConfig() {
+  g_state.scanBudgetBytes =
+      static_cast<ULONGLONG>(LoadUintFromConfigOrDefault(L"scan_budget_mb", kDefaultScanBudgetMegabytes)) * 1024 * 1024;
+  g_state.scanBudgetMs = LoadUintFromConfigOrDefault(L"scan_budget_ms", kDefaultScanBudgetMs);
+}
+
+// alert_min_level takes a zap level name; anything below warn, or unknown, falls back to the default.
+void LoadMinimumAlertLevelFromConfig() {
+  wchar_t levelBuffer[32] = {};
+  const DWORD charsRead = GetPrivateProfileStringW(
+      L"watcher",
+      L"alert_min_level",
+      L"",
+      levelBuffer,
+      static_cast<DWORD>(ARRAYSIZE(levelBuffer)),
+      g_state.configPath.c_str());
+
+  const AlertSeverity severity = SeverityOfLevelName(WideToUtf8(levelBuffer));
+  if (charsRead == 0 || !HasAlert(severity)) {
+    g_state.minimumAlertSeverity = SeverityOfLevelName(WideToUtf8(kDefaultMinimumAlertLevel));
+    WritePrivateProfileStringW(L"watcher", L"alert_min_level", kDefaultMinimumAlertLevel, g_state.configPath.c_str());
+    return;
+  }
+  g_state.minimumAlertSeverity = severity;
+}
+
+// alert_store=offsets keeps only where each alert line is and re-reads the line from the log when it
+// is shown, so a huge backlog costs a few bytes per alert; the default, memory, keeps the lines.
+void LoadAlertStoreModeFromConfig() {
+  wchar_t modeBuffer[32] = {};
+  GetPrivateProfileStringW(
+      L"watcher",
+      L"alert_store",
+      L"",
+      modeBuffer,
+      static_cast<DWORD>(ARRAYSIZE(modeBuffer)),
+      g_state.configPath.c_str());
+
+  if (lstrcmpiW(modeBuffer, L"offsets") == 0) {
+    g_state.activeAlerts.offsetsOnly = true;
+    return;
+  }
+  g_state.activeAlerts.offsetsOnly = false;
+  if (lstrcmpiW(modeBuffer, L"memory") != 0) {
+    WritePrivateProfileStringW(L"watcher", L"alert_store", L"memory", g_state.configPath.c_str());
+  }
+}
+
+// alert_memory_max_count and alert_memory_max_mb bound the alerts kept in memory; older ones spill to
+// the alert spill file. 0 lifts a limit. The scanner's alert candidates, one per occurrence, take at
+// most a quarter of alert_memory_max_mb on top of that, in either alert_store mode; with that limit
+// lifted they stop at kMaxAlertCandidates (see MaxAlertCandidatesForConfig).
+void LoadAlertRetentionFromConfig() {
+  g_state.maxResidentAlerts = LoadUintFromConfigOrDefault(L"alert_memory_max_count", kDefaultMaxResidentAlerts);
+  g_state.maxResidentAlertBytes =
+      static_cast<ULONGLONG>(LoadUintFromConfigOrDefault(L"alert_memory_max_mb", kDefaultMaxResidentAlertMegabytes)) *
+      1024 * 1024;
+}
+
 void LoadLogPathFromConfig() {
   wchar_t logPathBuffer[4096] = {};
   const DWORD charsRead = GetPrivateProfileStringW(
@@ -1556,13 +5006,23 @@ void LoadLogPathFromConfig() {
   LoadDoubleClickActionFromConfig();
   LoadAcknowledgePopupDurationFromConfig();
   LoadAcknowledgedOffsetFromConfig();
+  LoadScanBudgetFromConfig();
+  LoadMinimumAlertLevelFromConfig();
+  LoadAlertStoreModeFromConfig();
+  LoadAlertRetentionFromConfig();
 
   DebugLog(
       L"Config loaded. logPath=" + g_state.logPath +
       L", monitorIntervalMs=" + std::to_wstring(g_state.monitorIntervalMs) +
       L", useMinutes=" + std::to_wstring(g_state.monitorIntervalUseMinutes ? 1 : 0) +
       L", doubleClickAction=" + DoubleClickActionLabel(g_state.doubleClickAction) +
-      L", acknowledgedOffset=" + std::to_wstring(g_state.acknowledgedOffset));
+      L", acknowledgedOffset=" + std::to_wstring(g_state.acknowledgedOffset) +
+      L", scanBudgetBytes=" + std::to_wstring(g_state.scanBudgetBytes) +
+      L", scanBudgetMs=" + std::to_wstring(g_state.scanBudgetMs) +
+      L", minimumAlertSeverity=" + AlertSeverityLabel(g_state.minimumAlertSeverity) +
+      L", alertStore=" + (g_state.activeAlerts.offsetsOnly ? L"offsets" : L"memory") +
+      L", maxResidentAlerts=" + std::to_wstring(g_state.maxResidentAlerts) +
+      L", maxResidentAlertBytes=" + std::to_wstring(g_state.maxResidentAlertBytes));
 }
 
 bool TryQueryIgnoreListState(bool* outExists, std::filesystem::file_time_type* outLastWriteTime) {
@@ -1614,6 +5074,7 @@ void LoadIgnoreList() {
 
   std::ifstream inputFile(std::filesystem::path(g_state.ignorePath), std::ios::binary);
   if (!inputFile.is_open()) {
+    g_state.ignoreRuleSet = CompileIgnoreRuleSet(g_state.ignoredRules);
     DebugLog(L"Ignore list file not found. path=" + g_state.ignorePath);
     return;
   }
@@ -1629,6 +5090,7 @@ void LoadIgnoreList() {
     }
   }
 
+  g_state.ignoreRuleSet = CompileIgnoreRuleSet(g_state.ignoredRules);
   DebugLog(L"Ignore list loaded. count=" + std::to_wstring(g_state.ignoredRules.size()));
 }
 
@@ -1734,6 +5196,9 @@ void RefreshTrayIconVisualState() {
       tip += L"OK";
       break;
   }
+  if (g_state.scanCatchingUp) {
+    tip += L" (catching up " + std::to_wstring(g_state.scanProgressPercent) + L"%)";
+  }
 
   StringCchCopyW(g_state.trayIcon.szTip, ARRAYSIZE(g_state.trayIcon.szTip), tip.c_str());
   g_state.trayIcon.hIcon = icon;
@@ -1751,13 +5216,43 @@ bool AddTrayIcon() {
   return true;
 }
 
-bool TryGetLogFileSize(ULONGLONG* outSize) {
-  if (!outSize) {
+void CloseLogFileHandle() {
+  if (g_scanner.logFile != INVALID_HANDLE_VALUE) {
+    CloseHandle(g_scanner.logFile);
+    g_scanner.logFile = INVALID_HANDLE_VALUE;
+  }
+  // A later handle may get the same value, so parallel scan workers reopen theirs on the next job.
+  ++g_scanner.logFileGeneration;
+  g_scanner.logFileIdentity = {};
+}
+
+// While the path still names the held file, its size and last write time match what the handle
+// reports, so the common tick costs two metadata queries instead of an open/close pair.
+bool IsHeldLogFileCurrent() {
+  BY_HANDLE_FILE_INFORMATION heldInformation = {};
+  WIN32_FILE_ATTRIBUTE_DATA pathAttributes = {};
+  if (!GetFileInformationByHandle(g_scanner.logFile, &heldInformation) ||
+      !GetFileAttributesExW(g_scanner.logPath.c_str(), GetFileExInfoStandard, &pathAttributes)) {
     return false;
   }
+  return heldInformation.nFileSizeHigh == pathAttributes.nFileSizeHigh &&
+         heldInformation.nFileSizeLow == pathAttributes.nFileSizeLow &&
+         CompareFileTime(&heldInformation.ftLastWriteTime, &pathAttributes.ftLastWriteTime) == 0;
+}
+
+// Returns the shared-read handle kept open on the log across ticks. The path is only reopened when
+// it may name a different file than the held one; *outReplaced is set when it does (the log was
+// rotated or replaced), in which case everything read so far belongs to the old file.
+HANDLE AcquireLogFileHandle(bool* outReplaced) {
+  if (outReplaced) {
+    *outReplaced = false;
+  }
+  if (g_scanner.logFile != INVALID_HANDLE_VALUE && IsHeldLogFileCurrent()) {
+    return g_scanner.logFile;
+  }
 
   HANDLE file = CreateFileW(
-      g_state.logPath.c_str(),
+      g_scanner.logPath.c_str(),
       GENERIC_READ,
       FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
       nullptr,
@@ -1765,13 +5260,49 @@ bool TryGetLogFileSize(ULONGLONG* outSize) {
       FILE_ATTRIBUTE_NORMAL,
       nullptr);
   if (file == INVALID_HANDLE_VALUE) {
+    // Also releases a rotated-away file so its name can be reused.
+    CloseLogFileHandle();
+    return INVALID_HANDLE_VALUE;
+  }
+
+  LogFileIdentity identity = {};
+  TryGetLogFileIdentity(file, &identity);
+  if (g_scanner.logFile != INVALID_HANDLE_VALUE && !IsSameLogFileIdentity(identity, g_scanner.logFileIdentity)) {
+    DebugLog(L"Log file was replaced. path=" + g_scanner.logPath);
+    if (outReplaced) {
+      *outReplaced = true;
+    }
+  }
+  CloseLogFileHandle();
+  g_scanner.logFile = file;
+  g_scanner.logFileIdentity = identity;
+  return file;
+}
+
+// The bytes just before lastOffset are remembered so a log that was truncated and regrew past
+// lastOffset between two ticks is not mistaken for an append.
+void RememberLastOffsetTail(HANDLE file) {
+  g_scanner.hasLastOffsetTailHash =
+      file != INVALID_HANDLE_VALUE &&
+      TryHashBytesBeforeOffset(file, g_scanner.lastOffset, &g_scanner.lastOffsetTailHash);
+}
+
+bool LastOffsetTailStillMatches(HANDLE file) {
+  if (!g_scanner.hasLastOffsetTailHash) {
+    return true;
+  }
+  ULONGLONG tailHash = 0;
+  return TryHashBytesBeforeOffset(file, g_scanner.lastOffset, &tailHash) && tailHash == g_scanner.lastOffsetTailHash;
+}
+
+bool TryGetLogFileSize(ULONGLONG* outSize) {
+  if (!outSize) {
     return false;
   }
 
+  HANDLE file = AcquireLogFileHandle(nullptr);
   LARGE_INTEGER fileSize = {};
-  const bool ok = GetFileSizeEx(file, &fileSize) && fileSize.QuadPart >= 0;
-  CloseHandle(file);
-  if (!ok) {
+  if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < 0) {
     return false;
   }
 
@@ -1787,14 +5318,16 @@ void UpdateTrayIcon() {
   }
 }
 
-void RefreshAlertStateFromEntries() {
-  AlertSeverity highestSeverity = AlertSeverity::kNone;
-  for (const AlertEntry& entry : g_state.activeAlertEntries) {
-    if (!entry.isIgnored) {
-      highestSeverity = MaxAlertSeverity(highestSeverity, entry.severity);
-    }
+AlertSeverity HighestActiveAlertSeverity() {
+  unsigned char highestSeverity = g_state.activeAlerts.spilledHighestActiveSeverity;
+  for (const unsigned char severity : g_state.activeAlerts.activeSeverities) {
+    highestSeverity = (std::max)(highestSeverity, severity);
   }
-  g_state.alertSeverity = highestSeverity;
+  return static_cast<AlertSeverity>(highestSeverity);
+}
+
+void RefreshAlertStateFromEntries() {
+  g_state.alertSeverity = HighestActiveAlertSeverity();
   g_state.blinkShowAlertIcon = true;
   UpdateTrayIcon();
 }
@@ -1818,6 +5351,7 @@ bool AddIgnoredAlertRule(std::string_view rawLine) {
   }
 
   g_state.ignoredRules.push_back(std::move(rule));
+  g_state.ignoreRuleSet = CompileIgnoreRuleSet(g_state.ignoredRules);
   SaveIgnoreList();
   DebugLog(L"Ignored rule added.");
   return true;
@@ -1831,6 +5365,7 @@ bool RemoveIgnoredAlertRuleAt(size_t index) {
   using IgnoreVector = std::vector<IgnoreRule>;
   g_state.ignoredRules.erase(
       g_state.ignoredRules.begin() + static_cast<IgnoreVector::difference_type>(index));
+  g_state.ignoreRuleSet = CompileIgnoreRuleSet(g_state.ignoredRules);
   SaveIgnoreList();
   DebugLog(L"Ignored rule removed. newCount=" + std::to_wstring(g_state.ignoredRules.size()));
   return true;
@@ -1951,154 +5486,715 @@ void ShowAcknowledgeNotification() {
   int popupX = cursorPos.x - (kAcknowledgePopupWidth / 2);
   int popupY = cursorPos.y + kAcknowledgePopupOffsetPx;
 
-  if (popupY + kAcknowledgePopupHeight > workArea.bottom) {
-    popupY = cursorPos.y - kAcknowledgePopupHeight - kAcknowledgePopupOffsetPx;
+  if (popupY + kAcknowledgePopupHeight > workArea.bottom) {
+    popupY = cursorPos.y - kAcknowledgePopupHeight - kAcknowledgePopupOffsetPx;
+  }
+
+  popupX = (std::max)(
+      static_cast<int>(workArea.left),
+      (std::min)(popupX, static_cast<int>(workArea.right) - kAcknowledgePopupWidth));
+  popupY = (std::max)(
+      static_cast<int>(workArea.top),
+      (std::min)(popupY, static_cast<int>(workArea.bottom) - kAcknowledgePopupHeight));
+
+  HWND popupHwnd = CreateWindowExW(
+      WS_EX_TOPMOST | WS_EX_TOOLWINDOW | WS_EX_NOACTIVATE,
+      kAcknowledgePopupWindowClassName,
+      L"",
+      WS_POPUP,
+      popupX,
+      popupY,
+      kAcknowledgePopupWidth,
+      kAcknowledgePopupHeight,
+      g_state.hwnd,
+      nullptr,
+      GetModuleHandleW(nullptr),
+      nullptr);
+  if (!popupHwnd) {
+    return;
+  }
+
+  g_state.acknowledgePopupHwnd = popupHwnd;
+  ShowWindow(popupHwnd, SW_SHOWNOACTIVATE);
+  UpdateWindow(popupHwnd);
+  DebugLog(L"Acknowledge popup shown.");
+}
+
+// Producers push onto an atomic singly linked list; the single consumer takes the whole list with one
+// exchange and restores FIFO order. Returns true when the list was empty, i.e. the consumer needs a
+// wake-up.
+template <typename Node>
+bool PushAtomicList(std::atomic<Node*>* head, Node* node) {
+  node->next = head->load(std::memory_order_relaxed);
+  while (!head->compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+  }
+  return node->next == nullptr;
+}
+
+template <typename Node>
+Node* TakeAtomicListInOrder(std::atomic<Node*>* head) {
+  Node* node = head->exchange(nullptr, std::memory_order_acquire);
+  Node* ordered = nullptr;
+  while (node) {
+    Node* next = node->next;
+    node->next = ordered;
+    ordered = node;
+    node = next;
+  }
+  return ordered;
+}
+
+// Applied in the same order ApplyScanBatches applies the batch to the store.
+void RecordAlertCandidates(const ScanBatch& batch) {
+  std::vector<AlertCandidate>& candidates = g_scanner.alertCandidates;
+  if (batch.replacesEntries) {
+    candidates.clear();
+    g_scanner.alertCandidatesOverflowed = false;
+  }
+  if (g_scanner.alertCandidatesOverflowed) {
+    return;
+  }
+  candidates.resize(candidates.size() - (std::min)(batch.retractedEntryCount, candidates.size()));
+  if (candidates.size() + batch.entries.size() > g_scanner.maxAlertCandidates) {
+    DebugLog(L"Too many alert candidates to keep; rule changes will rescan the log.");
+    g_scanner.alertCandidatesOverflowed = true;
+    std::vector<AlertCandidate>().swap(candidates);
+    return;
+  }
+  for (const AlertEntry& entry : batch.entries) {
+    candidates.push_back(
+        {entry.lineOffset, entry.lineNumber, static_cast<UINT>(entry.rawLine.size()), entry.matchedIgnoreRuleId});
+  }
+}
+
+void PostScanBatch(std::unique_ptr<ScanBatch> batch) {
+  RecordAlertCandidates(*batch);
+  batch->ignoreRules = g_scanner.ignoreRules;
+  batch->catchingUp = g_scanner.catchingUp;
+  batch->catchUpStartOffset = g_scanner.catchUpStartOffset;
+  batch->scannedOffset = g_scanner.lastOffset;
+  batch->targetOffset = g_scanner.catchUpTargetOffset;
+  if (PushAtomicList(&g_state.scanBatches, batch.release()) && g_state.hwnd) {
+    PostMessageW(g_state.hwnd, kScanResultsMessage, 0, 0);
+  }
+}
+
+void UpdateUnterminatedTail(HANDLE file, ULONGLONG tailOffset, ULONGLONG fileSize, ScanBatch* batch) {
+  UnterminatedTail& tail = g_scanner.pendingTail;
+  if (tailOffset == fileSize) {
+    return;
+  }
+  if (tail.endOffset == 0) {
+    tail.endOffset = fileSize;
+    tail.firstSeenTick = GetTickCount64();
+    return;
+  }
+  if (tail.flushed || GetTickCount64() - tail.firstSeenTick < kUnterminatedLineFlushMs) {
+    return;
+  }
+
+  DebugLog(L"Flushing unterminated last line at offset " + std::to_wstring(tailOffset));
+  const size_t entryCountBefore = batch->entries.size();
+  const AlertSeverity tailSeverity = ScanFileRangeOnCurrentThread(
+      file,
+      tailOffset,
+      fileSize,
+      g_scanner.lastLineNumber,
+      nullptr,
+      &batch->entries,
+      nullptr,
+      &batch->ignoreMatchCost);
+  batch->highestSeverity = MaxAlertSeverity(batch->highestSeverity, tailSeverity);
+  tail.flushed = true;
+  tail.flushedEntryCount = batch->entries.size() - entryCountBefore;
+}
+
+// Milliseconds until a pending unterminated tail is due to be flushed, or INFINITE.
+DWORD UnterminatedTailFlushDelayMs() {
+  const UnterminatedTail& tail = g_scanner.pendingTail;
+  if (tail.endOffset == 0 || tail.flushed) {
+    return INFINITE;
+  }
+  const ULONGLONG elapsedMs = GetTickCount64() - tail.firstSeenTick;
+  return elapsedMs >= kUnterminatedLineFlushMs ? 0 : static_cast<DWORD>(kUnterminatedLineFlushMs - elapsedMs);
+}
+
+// The byte budget, lowered when scan_budget_ms is set to what the earlier slices got through in that
+// time. Until a slice of kMinTimedScanSliceBytes or more has been timed, that is the size it uses.
+ULONGLONG ScanSliceBytes() {
+  if (g_scanner.scanBudgetMs == 0) {
+    return g_scanner.scanBudgetBytes;
+  }
+  const ULONGLONG timedBytes = (std::max)(
+      kMinTimedScanSliceBytes,
+      static_cast<ULONGLONG>(g_scanner.scanBytesPerMs * g_scanner.scanBudgetMs));
+  return g_scanner.scanBudgetBytes == 0 ? timedBytes : (std::min)(g_scanner.scanBudgetBytes, timedBytes);
+}
+
+// Classifies the complete lines from the cursor on, or only up to the first line start past
+// ScanSliceBytes when the backlog is larger. The rest is picked up by the following slices, with the
+// command queue checked and a batch posted in between, so an error early in a burst escalates the icon
+// right away. A trailing line without its '\n' yet is left for UpdateUnterminatedTail.
+void ScanNextLogSlice(HANDLE file, ULONGLONG fileSize, ScanBatch* batch) {
+  if (g_scanner.pendingTail.endOffset != fileSize) {
+    // The tail grew or was finished, so a flushed version of it is classified again from its line start.
+    batch->retractedEntryCount += g_scanner.pendingTail.flushedEntryCount;
+    g_scanner.pendingTail = {};
+  }
+
+  if (!g_scanner.catchingUp) {
+    g_scanner.catchUpStartOffset = g_scanner.lastOffset;
+  }
+  const ULONGLONG completeLinesEnd = LineStartAfterLastNewline(file, g_scanner.lastOffset, fileSize);
+  ULONGLONG sliceEnd = completeLinesEnd;
+  const ULONGLONG sliceBytes = ScanSliceBytes();
+  if (sliceBytes != 0 && completeLinesEnd - g_scanner.lastOffset > sliceBytes) {
+    sliceEnd = LineStartAtOrAfter(file, g_scanner.lastOffset + sliceBytes, completeLinesEnd);
+  }
+
+  ULONGLONG endingLineNumber = g_scanner.lastLineNumber;
+  const ULONGLONG sliceStartTicks = PerformanceCounterTicks();
+  const AlertSeverity sliceSeverity = ScanFileRangeForAlertEntries(
+      file,
+      g_scanner.lastOffset,
+      sliceEnd,
+      g_scanner.lastLineNumber,
+      &endingLineNumber,
+      &batch->entries,
+      &g_scanner.lineCheckpoints,
+      &batch->ignoreMatchCost);
+  batch->highestSeverity = MaxAlertSeverity(batch->highestSeverity, sliceSeverity);
+  const double sliceMs = PerformanceTicksToMilliseconds(PerformanceCounterTicks() - sliceStartTicks);
+  if (sliceEnd - g_scanner.lastOffset >= kMinTimedScanSliceBytes && sliceMs > 0.0) {
+    g_scanner.scanBytesPerMs = static_cast<double>(sliceEnd - g_scanner.lastOffset) / sliceMs;
+  }
+  g_scanner.lastOffset = sliceEnd;
+  g_scanner.lastLineNumber = endingLineNumber;
+  g_scanner.catchingUp = sliceEnd < completeLinesEnd;
+  g_scanner.catchUpTargetOffset = completeLinesEnd;
+  if (!g_scanner.catchingUp) {
+    UpdateUnterminatedTail(file, sliceEnd, fileSize, batch);
+  }
+}
+
+void ScannerRescan() {
+  DebugLog(L"ScannerRescan started. scanKernels=" + std::wstring(SelectedScanKernels().name));
+  auto batch = std::make_unique<ScanBatch>();
+  batch->replacesEntries = true;
+  g_scanner.lastOffset = 0;
+  g_scanner.lastLineNumber = 0;
+  g_scanner.catchingUp = false;
+  g_scanner.pendingTail = {};
+
+  bool logReplaced = false;
+  HANDLE file = AcquireLogFileHandle(&logReplaced);
+  if (file != INVALID_HANDLE_VALUE) {
+    BindLineCheckpointsToFile(file, &g_scanner.lineCheckpoints);
+    LARGE_INTEGER fileSize = {};
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+      const ULONGLONG currentSize = static_cast<ULONGLONG>(fileSize.QuadPart);
+      if (g_scanner.acknowledgedOffset > currentSize || (logReplaced && g_scanner.acknowledgedOffset > 0)) {
+        g_scanner.acknowledgedOffset = 0;
+        batch->acknowledgedOffsetChanged = true;
+        batch->acknowledgedOffset = 0;
+      }
+      DropLineCheckpointsBeyond(&g_scanner.lineCheckpoints, currentSize);
+      g_scanner.lastLineNumber =
+          StartingLineNumberForOffset(file, g_scanner.acknowledgedOffset, &g_scanner.lineCheckpoints);
+      g_scanner.lastOffset = g_scanner.acknowledgedOffset;
+      ScanNextLogSlice(file, currentSize, batch.get());
+    }
+    RememberLastOffsetTail(file);
+    SaveLineCheckpointIndex(file, &g_scanner.lineCheckpoints);
+  }
+
+  DebugLog(
+      L"ScannerRescan finished. severity=" + std::wstring(AlertSeverityLabel(batch->highestSeverity)) +
+      L", entries=" + std::to_wstring(batch->entries.size()) +
+      L", lastOffset=" + std::to_wstring(g_scanner.lastOffset) +
+      L", lastLineNumber=" + std::to_wstring(g_scanner.lastLineNumber) +
+      L", catchingUp=" + std::to_wstring(g_scanner.catchingUp ? 1 : 0));
+  PostScanBatch(std::move(batch));
+}
+
+// Reads the lines behind candidates [begin, end) in file order and calls visit(candidate, line) for
+// each. Lines close together are fetched with one read.
+template <typename Visit>
+bool ReadAlertCandidateLines(HANDLE file, size_t begin, size_t end, std::string* buffer, Visit visit) {
+  const std::vector<AlertCandidate>& candidates = g_scanner.alertCandidates;
+  while (begin < end) {
+    const ULONGLONG blockOffset = candidates[begin].lineOffset;
+    ULONGLONG blockEnd = blockOffset + candidates[begin].lineLength;
+    size_t blockLast = begin + 1;
+    while (blockLast < end && candidates[blockLast].lineOffset >= blockEnd &&
+           candidates[blockLast].lineOffset - blockEnd <= kAlertCandidateReadGapBytes &&
+           candidates[blockLast].lineOffset + candidates[blockLast].lineLength - blockOffset <=
+               kAlertCandidateReadBlockBytes) {
+      blockEnd = candidates[blockLast].lineOffset + candidates[blockLast].lineLength;
+      ++blockLast;
+    }
+
+    LARGE_INTEGER filePointer = {};
+    filePointer.QuadPart = static_cast<LONGLONG>(blockOffset);
+    if (!SetFilePointerEx(file, filePointer, nullptr, FILE_BEGIN)) {
+      return false;
+    }
+    const DWORD blockBytes = static_cast<DWORD>(blockEnd - blockOffset);
+    buffer->resize(blockBytes);
+    DWORD totalRead = 0;
+    while (totalRead < blockBytes) {
+      DWORD bytesRead = 0;
+      if (!ReadFile(file, buffer->data() + totalRead, blockBytes - totalRead, &bytesRead, nullptr) ||
+          bytesRead == 0) {
+        return false;
+      }
+      totalRead += bytesRead;
+    }
+
+    const std::string_view block(*buffer);
+    for (; begin < blockLast; ++begin) {
+      const AlertCandidate& candidate = candidates[begin];
+      if (!visit(candidate, block.substr(candidate.lineOffset - blockOffset, candidate.lineLength))) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Maps rule ids of one rule set to another by rule text; kNoIgnoreRule where the rule is gone.
+std::vector<UINT> MapIgnoreRuleIds(const IgnoreRuleSet& from, const IgnoreRuleSet& to) {
+  std::unordered_map<std::string_view, UINT> idsByText;
+  for (UINT i = 0; i < to.rules.size(); ++i) {
+    idsByText.emplace(to.rules[i].text, i);
+  }
+  std::vector<UINT> mappedIds(from.rules.size(), kNoIgnoreRule);
+  for (UINT i = 0; i < from.rules.size(); ++i) {
+    const auto it = idsByText.find(from.rules[i].text);
+    if (it != idsByText.end()) {
+      mappedIds[i] = it->second;
+    }
+  }
+  return mappedIds;
+}
+
+// Applies a changed rule list to the entries already scanned, reading back only their lines. A line
+// known not to match any kept rule is tried against the added rules alone. A line matched by a kept
+// rule still is, so only added rules ahead of it can take it over. Only a line whose rule was removed
+// runs the whole matcher again. When kept rules were reordered, every line does. Falls back to a
+// rescan when the candidates were not kept or the log is no longer the file they came from.
+void ScannerReclassify(std::shared_ptr<const IgnoreRuleSet> ignoreRules) {
+  const std::shared_ptr<const IgnoreRuleSet> previousRules = std::move(g_scanner.ignoreRules);
+  g_scanner.ignoreRules = std::move(ignoreRules);
+  HANDLE file = g_scanner.logFile;
+  if (!previousRules || !g_scanner.ignoreRules || g_scanner.alertCandidatesOverflowed ||
+      file == INVALID_HANDLE_VALUE || !IsHeldLogFileCurrent() || !LastOffsetTailStillMatches(file)) {
+    DebugLog(L"ScannerReclassify cannot reuse the scanned alerts. Rescanning.");
+    ScannerRescan();
+    return;
+  }
+
+  const IgnoreRuleSet& rules = *g_scanner.ignoreRules;
+  const std::vector<UINT> keptRuleIds = MapIgnoreRuleIds(*previousRules, rules);
+  const std::vector<UINT> previousRuleIds = MapIgnoreRuleIds(rules, *previousRules);
+  std::vector<IgnoreRule> addedRules;
+  std::vector<UINT> addedRuleIds;
+  for (UINT i = 0; i < rules.rules.size(); ++i) {
+    if (previousRuleIds[i] == kNoIgnoreRule) {
+      addedRules.push_back(rules.rules[i]);
+      addedRuleIds.push_back(i);
+    }
+  }
+  bool keptRulesInOrder = true;
+  UINT lastKeptRuleId = 0;
+  for (const UINT keptRuleId : keptRuleIds) {
+    if (keptRuleId != kNoIgnoreRule) {
+      keptRulesInOrder = keptRulesInOrder && keptRuleId >= lastKeptRuleId;
+      lastKeptRuleId = keptRuleId;
+    }
+  }
+  const std::shared_ptr<const IgnoreRuleSet> addedRuleSet = CompileIgnoreRuleSet(addedRules);
+
+  auto batch = std::make_unique<ScanBatch>();
+  batch->replacesEntries = true;
+  batch->reclassified = true;
+  batch->entries.reserve(g_scanner.alertCandidates.size());
+  IgnoreMatchCost addedRulesCost;
+  size_t rematchedCount = 0;
+  std::string buffer;
+  const bool linesRead = ReadAlertCandidateLines(
+      file,
+      0,
+      g_scanner.alertCandidates.size(),
+      &buffer,
+      [&](const AlertCandidate& candidate, std::string_view line) {
+        AlertEntry entry = {};
+        if (!TryBuildAlertEntryFromLine(line, &entry)) {
+          return false;
+        }
+        entry.lineNumber = candidate.lineNumber;
+        entry.lineOffset = candidate.lineOffset;
+        entry.rawLine = std::string(line);
+
+        const UINT previousRuleId = candidate.matchedIgnoreRuleId;
+        const UINT keptRuleId = (previousRuleId < keptRuleIds.size()) ? keptRuleIds[previousRuleId] : kNoIgnoreRule;
+        UINT matchedRuleId = keptRuleId;
+        if (!keptRulesInOrder || (previousRuleId != kNoIgnoreRule && keptRuleId == kNoIgnoreRule)) {
+          const IgnoreRule* matchedRule =
+              FindMatchingIgnoreRule(rules, entry.rawLine, entry.fields, &batch->ignoreMatchCost);
+          matchedRuleId = matchedRule ? static_cast<UINT>(matchedRule - rules.rules.data()) : kNoIgnoreRule;
+          ++rematchedCount;
+        } else if (!addedRules.empty()) {
+          const IgnoreRule* addedRule =
+              FindMatchingIgnoreRule(*addedRuleSet, entry.rawLine, entry.fields, &addedRulesCost);
+          if (addedRule) {
+            matchedRuleId = (std::min)(matchedRuleId, addedRuleIds[addedRule - addedRuleSet->rules.data()]);
+          }
+        }
+        AppendClassifiedAlertEntry(std::move(entry), matchedRuleId, &batch->highestSeverity, &batch->entries);
+        return true;
+      });
+  if (!linesRead) {
+    DebugLog(L"ScannerReclassify could not read back the alert lines. Rescanning.");
+    ScannerRescan();
+    return;
+  }
+
+  if (!addedRulesCost.ruleTicks.empty()) {
+    batch->ignoreMatchCost.ruleTicks.resize(rules.rules.size(), 0);
+  }
+  for (size_t i = 0; i < addedRulesCost.ruleTicks.size(); ++i) {
+    batch->ignoreMatchCost.ruleTicks[addedRuleIds[i]] += addedRulesCost.ruleTicks[i];
+  }
+  batch->ignoreMatchCost.totalTicks += addedRulesCost.totalTicks;
+  batch->ignoreMatchCost.lineCount += addedRulesCost.lineCount;
+  DebugLog(
+      L"ScannerReclassify finished. entries=" + std::to_wstring(batch->entries.size()) +
+      L", addedRules=" + std::to_wstring(addedRules.size()) +
+      L", rematched=" + std::to_wstring(rematchedCount) +
+      L", keptRulesInOrder=" + std::to_wstring(keptRulesInOrder ? 1 : 0));
+  PostScanBatch(std::move(batch));
+}
+
+void ScannerPoll() {
+  auto batch = std::make_unique<ScanBatch>();
+  const bool wasCatchingUp = g_scanner.catchingUp;
+  bool logReplaced = false;
+  HANDLE file = AcquireLogFileHandle(&logReplaced);
+  if (file == INVALID_HANDLE_VALUE) {
+    g_scanner.catchingUp = false;
+    // Entries only exist for data that was scanned, so there is nothing to clear otherwise.
+    if (g_scanner.lastOffset != 0) {
+      batch->replacesEntries = true;
+      PostScanBatch(std::move(batch));
+    }
+    g_scanner.lastOffset = 0;
+    g_scanner.lastLineNumber = 0;
+    g_scanner.hasLastOffsetTailHash = false;
+    g_scanner.pendingTail = {};
+    ResetLineCheckpoints(&g_scanner.lineCheckpoints);
+    DebugLog(L"ScannerPoll: log file unavailable.");
+    return;
+  }
+
+  if (!g_scanner.lineCheckpoints.hasFileIdentity) {
+    BindLineCheckpointsToFile(file, &g_scanner.lineCheckpoints);
+  }
+
+  LARGE_INTEGER fileSize = {};
+  if (!GetFileSizeEx(file, &fileSize)) {
+    g_scanner.catchingUp = false;
+    return;
+  }
+
+  const ULONGLONG newSize = static_cast<ULONGLONG>(fileSize.QuadPart);
+  const bool logRestarted = logReplaced || newSize < g_scanner.lastOffset ||
+                            (newSize > g_scanner.lastOffset && !LastOffsetTailStillMatches(file));
+  if (logRestarted) {
+    DebugLog(L"ScannerPoll: log was replaced or truncated. Rescanning from the start.");
+    if (g_scanner.acknowledgedOffset != 0) {
+      g_scanner.acknowledgedOffset = 0;
+      batch->acknowledgedOffsetChanged = true;
+      batch->acknowledgedOffset = 0;
+    }
+    g_scanner.lastOffset = 0;
+    g_scanner.lastLineNumber = 0;
+    g_scanner.hasLastOffsetTailHash = false;
+    g_scanner.pendingTail = {};
+    ResetLineCheckpoints(&g_scanner.lineCheckpoints);
+    BindLineCheckpointsToFile(file, &g_scanner.lineCheckpoints);
+    batch->replacesEntries = true;
+    g_scanner.catchingUp = false;
+  }
+
+  // A catch-up in progress is continued, so its progress stays relative to where it started.
+  if (newSize > g_scanner.lastOffset) {
+    ScanNextLogSlice(file, newSize, batch.get());
+    RememberLastOffsetTail(file);
+  } else {
+    g_scanner.catchingUp = false;
+  }
+
+  if (batch->replacesEntries || !batch->entries.empty() || HasAlert(batch->highestSeverity) ||
+      batch->retractedEntryCount != 0 || g_scanner.catchingUp || wasCatchingUp) {
+    DebugLog(
+        L"ScannerPoll found changes. severity=" + std::wstring(AlertSeverityLabel(batch->highestSeverity)) +
+        L", entries=" + std::to_wstring(batch->entries.size()) +
+        L", lastOffset=" + std::to_wstring(g_scanner.lastOffset) +
+        L", catchingUp=" + std::to_wstring(g_scanner.catchingUp ? 1 : 0));
+    PostScanBatch(std::move(batch));
+  }
+}
+
+void ScannerAcknowledge() {
+  auto batch = std::make_unique<ScanBatch>();
+  batch->replacesEntries = true;
+  batch->acknowledged = true;
+  g_scanner.catchingUp = false;
+
+  ULONGLONG currentLogSize = 0;
+  if (TryGetLogFileSize(&currentLogSize)) {
+    HANDLE file = g_scanner.logFile;
+    // A line still being written has not been shown yet, so it is left for after the acknowledgement.
+    ULONGLONG acknowledgedOffset = currentLogSize;
+    if (!g_scanner.pendingTail.flushed) {
+      const ULONGLONG searchFrom = g_scanner.lastOffset <= currentLogSize ? g_scanner.lastOffset : 0;
+      acknowledgedOffset = LineStartAfterLastNewline(file, searchFrom, currentLogSize);
+    }
+    g_scanner.pendingTail = {};
+    g_scanner.lastOffset = acknowledgedOffset;
+    g_scanner.acknowledgedOffset = acknowledgedOffset;
+    BindLineCheckpointsToFile(file, &g_scanner.lineCheckpoints);
+    DropLineCheckpointsBeyond(&g_scanner.lineCheckpoints, currentLogSize);
+    g_scanner.lastLineNumber = StartingLineNumberForOffset(file, acknowledgedOffset, &g_scanner.lineCheckpoints);
+    RememberLastOffsetTail(file);
+    SaveLineCheckpointIndex(file, &g_scanner.lineCheckpoints);
+  } else {
+    g_scanner.pendingTail = {};
+    g_scanner.acknowledgedOffset = g_scanner.lastOffset;
+    if (g_scanner.lastOffset == 0) {
+      g_scanner.lastLineNumber = 0;
+    }
+  }
+  batch->acknowledgedOffsetChanged = true;
+  batch->acknowledgedOffset = g_scanner.acknowledgedOffset;
+  DebugLog(L"ScannerAcknowledge finished. acknowledgedOffset=" + std::to_wstring(g_scanner.acknowledgedOffset));
+  PostScanBatch(std::move(batch));
+}
+
+void ScannerSetLogPath(const std::wstring& logPath) {
+  SaveLineCheckpointIndex(g_scanner.logFile, &g_scanner.lineCheckpoints);
+  CloseLogFileHandle();
+  g_scanner.logPath = logPath;
+  g_scanner.acknowledgedOffset = 0;
+  g_scanner.hasLastOffsetTailHash = false;
+  ResetLineCheckpoints(&g_scanner.lineCheckpoints);
+  ScannerRescan();
+}
+
+// While a backlog is being caught up the thread does not block: it takes whatever commands arrived
+// since the last slice, runs them, and otherwise continues with the next slice. An unterminated tail
+// likewise gets a poll of its own once it is due to be flushed.
+DWORD WINAPI ScannerThreadProc(LPVOID) {
+  for (;;) {
+    const DWORD waitResult = WaitForSingleObject(
+        g_state.scannerWakeEvent,
+        g_scanner.catchingUp ? 0 : UnterminatedTailFlushDelayMs());
+    ScanCommand* command = TakeAtomicListInOrder(&g_state.scanCommands);
+    bool scannedThisRound = false;
+    while (command) {
+      std::unique_ptr<ScanCommand> current(command);
+      command = current->next;
+      switch (current->kind) {
+        case ScanCommandKind::kPoll:
+          // Anything a queued poll was meant to pick up is covered by the command that ran before it.
+          if (!scannedThisRound) {
+            ScannerPoll();
+          }
+          break;
+        case ScanCommandKind::kRescan:
+          g_scanner.ignoreRules = std::move(current->ignoreRules);
+          ScannerRescan();
+          break;
+        case ScanCommandKind::kReclassify:
+          ScannerReclassify(std::move(current->ignoreRules));
+          break;
+        case ScanCommandKind::kAcknowledge:
+          ScannerAcknowledge();
+          break;
+        case ScanCommandKind::kSetLogPath:
+          g_scanner.ignoreRules = std::move(current->ignoreRules);
+          ScannerSetLogPath(current->logPath);
+          break;
+        case ScanCommandKind::kShutdown:
+          while (command) {
+            std::unique_ptr<ScanCommand> discarded(command);
+            command = discarded->next;
+          }
+          SaveLineCheckpointIndex(g_scanner.logFile, &g_scanner.lineCheckpoints);
+          StopParallelScanPool();
+          CloseLogFileHandle();
+          return 0;
+      }
+      scannedThisRound = true;
+    }
+    if (!scannedThisRound && waitResult == WAIT_TIMEOUT) {
+      ScannerPoll();
+    }
+  }
+}
+
+void PostScanCommand(std::unique_ptr<ScanCommand> command) {
+  if (!g_state.scannerThread) {
+    return;
   }
+  PushAtomicList(&g_state.scanCommands, command.release());
+  SetEvent(g_state.scannerWakeEvent);
+}
 
-  popupX = (std::max)(
-      static_cast<int>(workArea.left),
-      (std::min)(popupX, static_cast<int>(workArea.right) - kAcknowledgePopupWidth));
-  popupY = (std::max)(
-      static_cast<int>(workArea.top),
-      (std::min)(popupY, static_cast<int>(workArea.bottom) - kAcknowledgePopupHeight));
+void PostScanCommand(ScanCommandKind kind) {
+  auto command = std::make_unique<ScanCommand>();
+  command->kind = kind;
+  PostScanCommand(std::move(command));
+}
 
-  HWND popupHwnd = CreateWindowExW(
-      WS_EX_TOPMOST | WS_EX_TOOLWINDOW | WS_EX_NOACTIVATE,
-      kAcknowledgePopupWindowClassName,
-      L"",
-      WS_POPUP,
-      popupX,
-      popupY,
-      kAcknowledgePopupWidth,
-      kAcknowledgePopupHeight,
-      g_state.hwnd,
-      nullptr,
-      GetModuleHandleW(nullptr),
-      nullptr);
-  if (!popupHwnd) {
-    return;
+std::shared_ptr<const IgnoreRuleSet> SnapshotIgnoreRules() {
+  if (!g_state.ignoreRuleSet) {
+    g_state.ignoreRuleSet = CompileIgnoreRuleSet(g_state.ignoredRules);
   }
+  return g_state.ignoreRuleSet;
+}
 
-  g_state.acknowledgePopupHwnd = popupHwnd;
-  ShowWindow(popupHwnd, SW_SHOWNOACTIVATE);
-  UpdateWindow(popupHwnd);
-  DebugLog(L"Acknowledge popup shown.");
+size_t MaxAlertCandidatesForConfig() {
+  if (g_state.maxResidentAlertBytes == 0) {
+    return kMaxAlertCandidates;
+  }
+  return static_cast<size_t>(g_state.maxResidentAlertBytes / 4 / sizeof(AlertCandidate));
 }
 
-void ResetWatcherAndRescan() {
-  DebugLog(L"ResetWatcherAndRescan started.");
-  g_state.lastOffset = 0;
-  g_state.lastLineNumber = 0;
-  g_state.activeAlertEntries.clear();
-  g_state.alertSeverity = AlertSeverity::kNone;
-  g_state.blinkShowAlertIcon = true;
+bool StartScannerThread() {
+  g_scanner.logPath = g_state.logPath;
+  g_scanner.acknowledgedOffset = g_state.acknowledgedOffset;
+  g_scanner.scanBudgetBytes = g_state.scanBudgetBytes;
+  g_scanner.scanBudgetMs = g_state.scanBudgetMs;
+  g_scanner.maxAlertCandidates = MaxAlertCandidatesForConfig();
+  g_scanner.minimumAlertSeverity = g_state.minimumAlertSeverity;
+  g_scanner.ignoreRules = SnapshotIgnoreRules();
+  LoadLineCheckpointIndex(&g_scanner.lineCheckpoints);
+
+  g_state.scannerWakeEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+  if (!g_state.scannerWakeEvent) {
+    return false;
+  }
+  g_state.scannerThread = CreateThread(nullptr, 0, ScannerThreadProc, nullptr, 0, nullptr);
+  return g_state.scannerThread != nullptr;
+}
 
-  HANDLE file = CreateFileW(
-      g_state.logPath.c_str(),
-      GENERIC_READ,
-      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
-      nullptr,
-      OPEN_EXISTING,
-      FILE_ATTRIBUTE_NORMAL,
-      nullptr);
-
-  if (file != INVALID_HANDLE_VALUE) {
-    LARGE_INTEGER fileSize = {};
-    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
-      const ULONGLONG currentSize = static_cast<ULONGLONG>(fileSize.QuadPart);
-      if (g_state.acknowledgedOffset > currentSize) {
-        g_state.acknowledgedOffset = 0;
-        SaveAcknowledgedOffsetToConfig(g_state.acknowledgedOffset);
-      }
-      const ULONGLONG startingLineNumber = StartingLineNumberForOffset(file, g_state.acknowledgedOffset);
-      g_state.alertSeverity = ScanFileRangeForAlertEntries(
-          file,
-          g_state.acknowledgedOffset,
-          currentSize,
-          startingLineNumber,
-          &g_state.lastLineNumber,
-          &g_state.activeAlertEntries);
-      g_state.lastOffset = currentSize;
+void StopScannerThread() {
+  if (g_state.scannerThread) {
+    PostScanCommand(ScanCommandKind::kShutdown);
+    if (WaitForSingleObject(g_state.scannerThread, kScannerShutdownTimeoutMs) != WAIT_OBJECT_0) {
+      // Still inside a long scan. The process is exiting, so leave it the state it is using.
+      DebugLog(L"Scanner thread did not stop in time.");
+      return;
     }
-    CloseHandle(file);
+    CloseHandle(g_state.scannerThread);
+    g_state.scannerThread = nullptr;
+  }
+  if (g_state.scannerWakeEvent) {
+    CloseHandle(g_state.scannerWakeEvent);
+    g_state.scannerWakeEvent = nullptr;
   }
 
-  UpdateTrayIcon();
-  RefreshAlertManagerWindowContent();
-  DebugLog(
-      L"ResetWatcherAndRescan finished. severity=" + std::wstring(AlertSeverityLabel(g_state.alertSeverity)) +
-      L", entries=" + std::to_wstring(g_state.activeAlertEntries.size()) +
-      L", lastOffset=" + std::to_wstring(g_state.lastOffset) +
-      L", lastLineNumber=" + std::to_wstring(g_state.lastLineNumber));
+  ScanBatch* batch = TakeAtomicListInOrder(&g_state.scanBatches);
+  while (batch) {
+    std::unique_ptr<ScanBatch> discarded(batch);
+    batch = discarded->next;
+  }
 }
 
-void MonitorLogFileOnce() {
-  DebugLog(L"MonitorLogFileOnce tick started.");
-  if (ReloadIgnoreListIfChanged(false)) {
-    DebugLog(L"Ignore list changed on disk. Rescanning log.");
-    ResetWatcherAndRescan();
+// Hits are taken from the batch's entries, so they count exactly the lines the store receives.
+void RecordIgnoreRuleStats(const ScanBatch& batch) {
+  if (!batch.ignoreRules) {
     return;
   }
+  const std::vector<IgnoreRule>& rules = batch.ignoreRules->rules;
+  for (const AlertEntry& entry : batch.entries) {
+    if (!entry.isIgnored || entry.matchedIgnoreRuleId >= rules.size()) {
+      continue;
+    }
+    IgnoreRuleStats& stats = g_state.ignoreRuleStats[rules[entry.matchedIgnoreRuleId].text];
+    ++stats.hits;
+    stats.lastHitLine = (std::max)(stats.lastHitLine, entry.lineNumber);
+  }
 
-  HANDLE file = CreateFileW(
-      g_state.logPath.c_str(),
-      GENERIC_READ,
-      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
-      nullptr,
-      OPEN_EXISTING,
-      FILE_ATTRIBUTE_NORMAL,
-      nullptr);
-
-  if (file == INVALID_HANDLE_VALUE) {
-    const bool hadActiveAlerts = !g_state.activeAlertEntries.empty();
-    g_state.activeAlertEntries.clear();
-    if (HasAlert(g_state.alertSeverity) || hadActiveAlerts) {
-      g_state.alertSeverity = AlertSeverity::kNone;
-      g_state.blinkShowAlertIcon = true;
-      UpdateTrayIcon();
-      RefreshAlertManagerWindowContent();
+  const IgnoreMatchCost& cost = batch.ignoreMatchCost;
+  for (size_t i = 0; i < cost.ruleTicks.size() && i < rules.size(); ++i) {
+    if (cost.ruleTicks[i] != 0) {
+      g_state.ignoreRuleStats[rules[i].text].matchTicks += cost.ruleTicks[i];
     }
-    g_state.lastOffset = 0;
-    g_state.lastLineNumber = 0;
-    DebugLog(L"MonitorLogFileOnce: log file unavailable.");
+  }
+  g_state.ignoreMatchTicks += cost.totalTicks;
+  g_state.ignoreMatchLineCount += cost.lineCount;
+}
+
+// A retracted tail line is classified again by a later batch, so its hit must not be counted twice.
+// Runs before RetractNewestAlertOccurrences, while the journal still names the rows.
+void ForgetRetractedIgnoreRuleHits(size_t count) {
+  const AlertStore& store = g_state.activeAlerts;
+  if (!store.ignoreRules) {
     return;
   }
-
-  LARGE_INTEGER fileSize = {};
-  if (!GetFileSizeEx(file, &fileSize)) {
-    CloseHandle(file);
-    return;
-  }
+  const size_t journalSize = store.appendJournal.size();
+  for (size_t i = journalSize - (std::min)(count, journalSize); i < journalSize; ++i) {
+    const UINT ruleId = store.matchedIgnoreRuleIds[store.appendJournal[i].alertIndex - store.spilledCount];
+    if (ruleId >= store.ignoreRules->rules.size()) {
+      continue;
+    }
+    const auto it = g_state.ignoreRuleStats.find(store.ignoreRules->rules[ruleId].text);
+    if (it != g_state.ignoreRuleStats.end() && it->second.hits != 0) {
+      --it->second.hits;
+    }
+  }
+}
 
-  const ULONGLONG newSize = static_cast<ULONGLONG>(fileSize.QuadPart);
+// Runs on the UI thread for kScanResultsMessage. Scanning happens elsewhere; this only applies the
+// resulting deltas to the alert list, tray icon and config.
+void ApplyScanBatches() {
+  ScanBatch* batch = TakeAtomicListInOrder(&g_state.scanBatches);
   bool needIconRefresh = false;
   bool needAlertWindowRefresh = false;
-
-  if (newSize < g_state.lastOffset) {
-    if (g_state.acknowledgedOffset > newSize) {
-      g_state.acknowledgedOffset = 0;
-      SaveAcknowledgedOffsetToConfig(g_state.acknowledgedOffset);
+  bool acknowledged = false;
+  while (batch) {
+    std::unique_ptr<ScanBatch> current(batch);
+    batch = current->next;
+
+    if (current->replacesEntries) {
+      ClearAlertStore(&g_state.activeAlerts);
+      if (current->reclassified) {
+        // The hits are counted again from the reclassified entries; the time spent so far still counts.
+        for (auto& [ruleText, stats] : g_state.ignoreRuleStats) {
+          stats.hits = 0;
+          stats.lastHitLine = 0;
+        }
+      } else {
+        g_state.ignoreRuleStats.clear();
+        g_state.ignoreMatchTicks = 0;
+        g_state.ignoreMatchLineCount = 0;
+      }
+      g_state.alertSeverity = AlertSeverity::kNone;
+      g_state.blinkShowAlertIcon = true;
+      needIconRefresh = true;
+      needAlertWindowRefresh = true;
+    }
+    if (current->retractedEntryCount != 0) {
+      ForgetRetractedIgnoreRuleHits(current->retractedEntryCount);
+      RetractNewestAlertOccurrences(&g_state.activeAlerts, current->retractedEntryCount);
+      g_state.alertSeverity = HighestActiveAlertSeverity();
+      needIconRefresh = true;
+      needAlertWindowRefresh = true;
     }
-    g_state.lastOffset = 0;
-    g_state.lastLineNumber = 0;
-    g_state.activeAlertEntries.clear();
-    g_state.alertSeverity = AlertSeverity::kNone;
-    g_state.blinkShowAlertIcon = true;
-    needIconRefresh = true;
-    needAlertWindowRefresh = true;
-  }
-
-  if (newSize > g_state.lastOffset) {
-    std::vector<AlertEntry> newEntries;
-    ULONGLONG endingLineNumber = g_state.lastLineNumber;
-    const AlertSeverity newSeverity = ScanFileRangeForAlertEntries(
-        file,
-        g_state.lastOffset,
-        newSize,
-        g_state.lastLineNumber,
-        &endingLineNumber,
-        &newEntries);
-    const AlertSeverity updatedSeverity = MaxAlertSeverity(g_state.alertSeverity, newSeverity);
+    const AlertSeverity updatedSeverity = MaxAlertSeverity(g_state.alertSeverity, current->highestSeverity);
     if (updatedSeverity != g_state.alertSeverity) {
       g_state.alertSeverity = updatedSeverity;
       if (HasAlert(g_state.alertSeverity)) {
@@ -2106,16 +6202,32 @@ void MonitorLogFileOnce() {
       }
       needIconRefresh = true;
     }
-    if (!newEntries.empty()) {
-      g_state.activeAlertEntries.insert(
-          g_state.activeAlertEntries.end(),
-          std::make_move_iterator(newEntries.begin()),
-          std::make_move_iterator(newEntries.end()));
-        needAlertWindowRefresh = true;
+    RecordIgnoreRuleStats(*current);
+    if (!current->entries.empty()) {
+      g_state.activeAlerts.ignoreRules = current->ignoreRules;
+      for (const AlertEntry& entry : current->entries) {
+        AppendAlertToStore(&g_state.activeAlerts, entry);
       }
-      g_state.lastOffset = newSize;
-      g_state.lastLineNumber = endingLineNumber;
+      needAlertWindowRefresh = true;
+    }
+    if (current->acknowledgedOffsetChanged && current->acknowledgedOffset != g_state.acknowledgedOffset) {
+      g_state.acknowledgedOffset = current->acknowledgedOffset;
+      SaveAcknowledgedOffsetToConfig(g_state.acknowledgedOffset);
+    }
+    acknowledged = acknowledged || current->acknowledged;
+
+    // Relative to where the catch-up started, so resuming near the end of a large log starts at 0%.
+    const ULONGLONG catchUpBytes = current->targetOffset - current->catchUpStartOffset;
+    const UINT progressPercent =
+        (current->catchingUp && current->targetOffset > current->catchUpStartOffset)
+            ? static_cast<UINT>((current->scannedOffset - current->catchUpStartOffset) * 100 / catchUpBytes)
+            : 0;
+    if (current->catchingUp != g_state.scanCatchingUp || progressPercent != g_state.scanProgressPercent) {
+      g_state.scanCatchingUp = current->catchingUp;
+      g_state.scanProgressPercent = progressPercent;
+      needIconRefresh = true;
     }
+  }
 
   if (needIconRefresh) {
     UpdateTrayIcon();
@@ -2123,12 +6235,44 @@ void MonitorLogFileOnce() {
   if (needAlertWindowRefresh) {
     RefreshAlertManagerWindowContent();
   }
-
-  CloseHandle(file);
+  if (acknowledged) {
+    ShowAcknowledgeNotification();
+  }
   DebugLog(
-      L"MonitorLogFileOnce finished. severity=" + std::wstring(AlertSeverityLabel(g_state.alertSeverity)) +
-      L", entries=" + std::to_wstring(g_state.activeAlertEntries.size()) +
-      L", lastOffset=" + std::to_wstring(g_state.lastOffset));
+      L"ApplyScanBatches finished. severity=" + std::wstring(AlertSeverityLabel(g_state.alertSeverity)) +
+      L", entries=" + std::to_wstring(AlertCount(g_state.activeAlerts)));
+}
+
+void ResetWatcherAndRescan() {
+  DebugLog(L"ResetWatcherAndRescan requested.");
+  auto command = std::make_unique<ScanCommand>();
+  command->kind = ScanCommandKind::kRescan;
+  command->ignoreRules = SnapshotIgnoreRules();
+  PostScanCommand(std::move(command));
+}
+
+// The scanner re-applies the current rules to the alerts it already found, without re-reading the log.
+void ReclassifyAlertsWithCurrentRules() {
+  DebugLog(L"ReclassifyAlertsWithCurrentRules requested.");
+  auto command = std::make_unique<ScanCommand>();
+  command->kind = ScanCommandKind::kReclassify;
+  command->ignoreRules = SnapshotIgnoreRules();
+  PostScanCommand(std::move(command));
+}
+
+void MonitorLogFileOnce() {
+  DebugLog(L"MonitorLogFileOnce tick started.");
+  if (ReloadIgnoreListIfChanged(false)) {
+    DebugLog(L"Ignore list changed on disk. Reclassifying alerts.");
+    ReclassifyAlertsWithCurrentRules();
+    return;
+  }
+  PostScanCommand(ScanCommandKind::kPoll);
+}
+
+void AcknowledgeAlert() {
+  DebugLog(L"AcknowledgeAlert requested.");
+  PostScanCommand(ScanCommandKind::kAcknowledge);
 }
 
 void OpenLogFolder() {
@@ -2172,38 +6316,251 @@ void OpenIgnoreListFile() {
   }
 }
 
-void AcknowledgeAlert() {
-  DebugLog(L"AcknowledgeAlert requested.");
-  ULONGLONG currentLogSize = 0;
-  if (TryGetLogFileSize(&currentLogSize)) {
-    g_state.lastOffset = currentLogSize;
-    g_state.acknowledgedOffset = currentLogSize;
-    HANDLE file = CreateFileW(
-        g_state.logPath.c_str(),
-        GENERIC_READ,
+// One tab-separated row per rule, in list order, with the rule text last since it may contain tabs.
+void ExportIgnoreRuleStats() {
+  wchar_t filePathBuffer[4096] = {};
+  const std::filesystem::path defaultPath =
+      std::filesystem::path(g_state.ignorePath).parent_path() / L"IgnoreRuleStats.tsv";
+  StringCchCopyW(filePathBuffer, ARRAYSIZE(filePathBuffer), defaultPath.wstring().c_str());
+
+  OPENFILENAMEW ofn = {};
+  ofn.lStructSize = sizeof(ofn);
+  ofn.hwndOwner = g_state.alertManagerHwnd ? g_state.alertManagerHwnd : g_state.hwnd;
+  ofn.lpstrFile = filePathBuffer;
+  ofn.nMaxFile = static_cast<DWORD>(ARRAYSIZE(filePathBuffer));
+  ofn.lpstrFilter = L"Tab-separated values (*.tsv)\0*.tsv\0All files (*.*)\0*.*\0";
+  ofn.lpstrDefExt = L"tsv";
+  ofn.Flags = OFN_EXPLORER | OFN_PATHMUSTEXIST | OFN_OVERWRITEPROMPT;
+  ofn.lpstrTitle = L"Export ignore rule stats";
+  if (!GetSaveFileNameW(&ofn)) {
+    DebugLog(L"ExportIgnoreRuleStats canceled.");
+    return;
+  }
+
+  std::ofstream outputFile(std::filesystem::path(filePathBuffer), std::ios::binary | std::ios::trunc);
+  if (!outputFile.is_open()) {
+    DebugLog(L"Failed to open ignore rule stats for writing. path=" + std::wstring(filePathBuffer));
+    MessageBoxW(ofn.hwndOwner, L"Cannot write the rule stats file.", L"Backrest Watcher", MB_ICONERROR | MB_OK);
+    return;
+  }
+
+  outputFile << "hits\tlast_hit_line\tpattern_ms\trule\n";
+  char patternMs[32] = {};
+  for (const IgnoreRule& rule : g_state.ignoredRules) {
+    const IgnoreRuleStats* stats = FindIgnoreRuleStats(rule);
+    const IgnoreRuleStats empty = {};
+    const IgnoreRuleStats& ruleStats = stats ? *stats : empty;
+    StringCchPrintfA(patternMs, ARRAYSIZE(patternMs), "%.3f", PerformanceTicksToMilliseconds(ruleStats.matchTicks));
+    outputFile << ruleStats.hits << '\t' << ruleStats.lastHitLine << '\t' << patternMs << '\t' << rule.text << '\n';
+  }
+  outputFile.flush();
+  DebugLog(
+      L"Ignore rule stats exported. path=" + std::wstring(filePathBuffer) +
+      L", count=" + std::to_wstring(g_state.ignoredRules.size()));
+}
+
+struct DirectoryChangeWatch {
+  std::wstring directory;
+  std::vector<std::wstring> fileNames;
+  HANDLE directoryHandle = INVALID_HANDLE_VALUE;
+  HANDLE event = nullptr;
+  OVERLAPPED overlapped = {};
+  std::vector<DWORD> buffer;
+};
+
+// Owned by the notifier thread once it starts; the UI thread only keeps the thread and stop event.
+struct LogChangeNotifierContext {
+  HWND targetHwnd = nullptr;
+  HANDLE stopEvent = nullptr;
+  std::vector<DirectoryChangeWatch> watches;
+};
+
+void CloseDirectoryChangeWatch(DirectoryChangeWatch* watch) {
+  if (watch->directoryHandle != INVALID_HANDLE_VALUE) {
+    CancelIoEx(watch->directoryHandle, &watch->overlapped);
+    DWORD ignoredBytes = 0;
+    GetOverlappedResult(watch->directoryHandle, &watch->overlapped, &ignoredBytes, TRUE);
+    CloseHandle(watch->directoryHandle);
+    watch->directoryHandle = INVALID_HANDLE_VALUE;
+  }
+  if (watch->event) {
+    CloseHandle(watch->event);
+    watch->event = nullptr;
+  }
+}
+
+bool IssueDirectoryChangeRead(DirectoryChangeWatch* watch) {
+  ResetEvent(watch->event);
+  watch->overlapped = {};
+  watch->overlapped.hEvent = watch->event;
+  return ReadDirectoryChangesW(
+             watch->directoryHandle,
+             watch->buffer.data(),
+             static_cast<DWORD>(watch->buffer.size() * sizeof(DWORD)),
+             FALSE,
+             FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE,
+             nullptr,
+             &watch->overlapped,
+             nullptr) != FALSE;
+}
+
+// An empty completion means the change buffer overflowed, which is reported as a relevant change.
+bool DirectoryChangesTouchWatchedFile(const DirectoryChangeWatch& watch, DWORD bytesTransferred) {
+  if (bytesTransferred == 0) {
+    return true;
+  }
+
+  const BYTE* record = reinterpret_cast<const BYTE*>(watch.buffer.data());
+  for (;;) {
+    const auto* information = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(record);
+    const std::wstring_view fileName(information->FileName, information->FileNameLength / sizeof(wchar_t));
+    for (const std::wstring& watchedName : watch.fileNames) {
+      if (EqualsTextInsensitive(fileName, watchedName)) {
+        return true;
+      }
+    }
+    if (information->NextEntryOffset == 0) {
+      return false;
+    }
+    record += information->NextEntryOffset;
+  }
+}
+
+void PostLogChangedMessage(HWND targetHwnd) {
+  // Bursts of appends collapse into one pending message; the UI thread clears the flag before it
+  // scans so a change during the scan posts again.
+  if (!g_state.logChangePending.exchange(true)) {
+    PostMessageW(targetHwnd, kLogChangedMessage, 0, 0);
+  }
+}
+
+DWORD WINAPI LogChangeNotifierThreadProc(LPVOID parameter) {
+  LogChangeNotifierContext* context = static_cast<LogChangeNotifierContext*>(parameter);
+  std::vector<HANDLE> waitHandles;
+  waitHandles.push_back(context->stopEvent);
+  for (DirectoryChangeWatch& watch : context->watches) {
+    waitHandles.push_back(watch.event);
+  }
+
+  for (;;) {
+    const DWORD waitResult =
+        WaitForMultipleObjects(static_cast<DWORD>(waitHandles.size()), waitHandles.data(), FALSE, INFINITE);
+    if (waitResult < WAIT_OBJECT_0 + 1 || waitResult >= WAIT_OBJECT_0 + waitHandles.size()) {
+      break;
+    }
+
+    DirectoryChangeWatch& watch = context->watches[waitResult - WAIT_OBJECT_0 - 1];
+    DWORD bytesTransferred = 0;
+    const bool completed =
+        GetOverlappedResult(watch.directoryHandle, &watch.overlapped, &bytesTransferred, FALSE) != FALSE;
+    if (!completed || DirectoryChangesTouchWatchedFile(watch, bytesTransferred)) {
+      PostLogChangedMessage(context->targetHwnd);
+    }
+    if (!completed || !IssueDirectoryChangeRead(&watch)) {
+      // The directory went away. Let the UI thread fall back to polling until it can restart us.
+      PostMessageW(context->targetHwnd, kLogChangedMessage, kLogChangeNotifierStopped, 0);
+      break;
+    }
+  }
+
+  for (DirectoryChangeWatch& watch : context->watches) {
+    CloseDirectoryChangeWatch(&watch);
+  }
+  delete context;
+  return 0;
+}
+
+void AddDirectoryChangeWatch(LogChangeNotifierContext* context, const std::filesystem::path& filePath) {
+  const std::wstring directory = filePath.parent_path().wstring();
+  const std::wstring fileName = filePath.filename().wstring();
+  for (DirectoryChangeWatch& watch : context->watches) {
+    if (EqualsTextInsensitive(watch.directory, directory)) {
+      watch.fileNames.push_back(fileName);
+      return;
+    }
+  }
+
+  DirectoryChangeWatch watch = {};
+  watch.directory = directory;
+  watch.fileNames.push_back(fileName);
+  context->watches.push_back(std::move(watch));
+}
+
+void StopLogChangeNotifier() {
+  if (g_state.logChangeNotifierThread) {
+    SetEvent(g_state.logChangeNotifierStopEvent);
+    WaitForSingleObject(g_state.logChangeNotifierThread, INFINITE);
+    CloseHandle(g_state.logChangeNotifierThread);
+    g_state.logChangeNotifierThread = nullptr;
+  }
+  if (g_state.logChangeNotifierStopEvent) {
+    CloseHandle(g_state.logChangeNotifierStopEvent);
+    g_state.logChangeNotifierStopEvent = nullptr;
+  }
+}
+
+// Watches the directories holding the log and Ignore.txt and posts kLogChangedMessage when either
+// file changes, so appends are picked up immediately instead of on the next poll. Returns false when
+// change notification is unavailable and polling has to carry on alone.
+bool StartLogChangeNotifier() {
+  StopLogChangeNotifier();
+  if (!g_state.hwnd || g_state.logPath.empty()) {
+    return false;
+  }
+
+  auto* context = new LogChangeNotifierContext();
+  context->targetHwnd = g_state.hwnd;
+  AddDirectoryChangeWatch(context, std::filesystem::path(g_state.logPath));
+  AddDirectoryChangeWatch(context, std::filesystem::path(g_state.ignorePath));
+
+  g_state.logChangeNotifierLastStartTick = GetTickCount64();
+  bool ready = true;
+  for (DirectoryChangeWatch& watch : context->watches) {
+    watch.buffer.resize(kDirectoryChangeBufferBytes / sizeof(DWORD));
+    watch.directoryHandle = CreateFileW(
+        watch.directory.c_str(),
+        FILE_LIST_DIRECTORY,
         FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
         nullptr,
         OPEN_EXISTING,
-        FILE_ATTRIBUTE_NORMAL,
+        FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
         nullptr);
-    if (file != INVALID_HANDLE_VALUE) {
-      g_state.lastLineNumber = CountLogicalLinesUpToOffset(file, currentLogSize);
-      CloseHandle(file);
+    watch.event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (watch.directoryHandle == INVALID_HANDLE_VALUE || !watch.event || !IssueDirectoryChangeRead(&watch)) {
+      DebugLog(L"Cannot watch directory for changes. directory=" + watch.directory);
+      ready = false;
+      break;
     }
-  } else {
-    g_state.acknowledgedOffset = g_state.lastOffset;
-    if (g_state.lastOffset == 0) {
-      g_state.lastLineNumber = 0;
+  }
+
+  const size_t directoryCount = context->watches.size();
+  g_state.logChangeNotifierStopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+  context->stopEvent = g_state.logChangeNotifierStopEvent;
+  if (ready && context->stopEvent) {
+    g_state.logChangeNotifierThread =
+        CreateThread(nullptr, 0, LogChangeNotifierThreadProc, context, 0, nullptr);
+  }
+  if (!g_state.logChangeNotifierThread) {
+    for (DirectoryChangeWatch& watch : context->watches) {
+      CloseDirectoryChangeWatch(&watch);
     }
+    delete context;
+    StopLogChangeNotifier();
+    DebugLog(L"Log change notifier unavailable. Falling back to polling.");
+    return false;
   }
-  SaveAcknowledgedOffsetToConfig(g_state.acknowledgedOffset);
-  g_state.activeAlertEntries.clear();
-  g_state.alertSeverity = AlertSeverity::kNone;
-  g_state.blinkShowAlertIcon = true;
-  UpdateTrayIcon();
-  RefreshAlertManagerWindowContent();
-  ShowAcknowledgeNotification();
-  DebugLog(L"AcknowledgeAlert finished. acknowledgedOffset=" + std::to_wstring(g_state.acknowledgedOffset));
+
+  DebugLog(L"Log change notifier started. directories=" + std::to_wstring(directoryCount));
+  return true;
+}
+
+// With change notification running the timer is only a safety net for missed or coalesced events
+// (e.g. network shares that do not report appends).
+UINT EffectiveMonitorIntervalMs() {
+  if (!g_state.logChangeNotifierThread) {
+    return g_state.monitorIntervalMs;
+  }
+  return (std::max)(g_state.monitorIntervalMs, kSafetyNetMonitorIntervalMs);
 }
 
 void ApplyMonitorInterval() {
@@ -2211,10 +6568,22 @@ void ApplyMonitorInterval() {
     return;
   }
   KillTimer(g_state.hwnd, kMonitorTimerId);
-  if (SetTimer(g_state.hwnd, kMonitorTimerId, g_state.monitorIntervalMs, nullptr) == 0) {
+  if (SetTimer(g_state.hwnd, kMonitorTimerId, EffectiveMonitorIntervalMs(), nullptr) == 0) {
     MessageBoxW(g_state.hwnd, L"Cannot update log monitoring timer.", L"Backrest Watcher", MB_ICONERROR | MB_OK);
   }
-  DebugLog(L"ApplyMonitorInterval set timer to " + std::to_wstring(g_state.monitorIntervalMs) + L" ms.");
+  DebugLog(L"ApplyMonitorInterval set timer to " + std::to_wstring(EffectiveMonitorIntervalMs()) + L" ms.");
+}
+
+// Called from the monitor timer while polling alone, so notification resumes once the directories
+// are reachable again without retrying on every short poll.
+void RetryLogChangeNotifierIfStopped() {
+  if (g_state.logChangeNotifierThread ||
+      GetTickCount64() - g_state.logChangeNotifierLastStartTick < kSafetyNetMonitorIntervalMs) {
+    return;
+  }
+  if (StartLogChangeNotifier()) {
+    ApplyMonitorInterval();
+  }
 }
 
 void SetMonitorInterval(UINT intervalMs, bool useMinutes) {
@@ -2645,6 +7014,18 @@ void PromptAndSetDoubleClickAction() {
   DebugLog(L"PromptAndSetDoubleClickAction accepted. action=" + std::wstring(DoubleClickActionLabel(g_state.doubleClickAction)));
 }
 
+size_t SelectedActiveAlertIndex() {
+  if (!g_state.activeAlertsListHwnd) {
+    return AlertCount(g_state.activeAlerts);
+  }
+
+  const int selectedIndex = static_cast<int>(SendMessageW(g_state.activeAlertsListHwnd, LB_GETCURSEL, 0, 0));
+  if (selectedIndex == LB_ERR) {
+    return AlertCount(g_state.activeAlerts);
+  }
+  return ActiveAlertIndexFromListIndex(static_cast<UINT>(selectedIndex));
+}
+
 size_t SelectedListItemDataIndex(HWND listBoxHwnd, size_t maxValidSize) {
   if (!listBoxHwnd) {
     return maxValidSize;
@@ -2672,7 +7053,7 @@ void UpdateActiveAlertsSelectionDetails() {
     return;
   }
 
-  if (g_state.activeAlertEntries.empty()) {
+  if (AlertCount(g_state.activeAlerts) == 0) {
     SetWindowTextW(
         g_state.activeAlertsDetailsHwnd,
         L"No warn/error messages are waiting right now.");
@@ -2680,10 +7061,8 @@ void UpdateActiveAlertsSelectionDetails() {
     return;
   }
 
-  const size_t selectedIndex = SelectedListItemDataIndex(
-      g_state.activeAlertsListHwnd,
-      g_state.activeAlertEntries.size());
-  if (selectedIndex >= g_state.activeAlertEntries.size()) {
+  const size_t selectedIndex = SelectedActiveAlertIndex();
+  if (selectedIndex >= AlertCount(g_state.activeAlerts)) {
     SetWindowTextW(
         g_state.activeAlertsDetailsHwnd,
         L"Select a message above to view details. Double-click a message to jump to that line in backrest.log.");
@@ -2691,9 +7070,9 @@ void UpdateActiveAlertsSelectionDetails() {
     return;
   }
 
-  const AlertEntry& entry = g_state.activeAlertEntries[selectedIndex];
-  SetWindowTextW(g_state.activeAlertsDetailsHwnd, entry.detailText.c_str());
-  EnableWindow(g_state.ignoreSelectedButtonHwnd, entry.isIgnored ? FALSE : TRUE);
+  const AlertView alert = StoredAlertView(&g_state.activeAlerts, selectedIndex);
+  SetWindowTextW(g_state.activeAlertsDetailsHwnd, FormatAlertDetailText(alert).c_str());
+  EnableWindow(g_state.ignoreSelectedButtonHwnd, alert.isIgnored ? FALSE : TRUE);
 }
 
 void UpdateIgnoredAlertsSelectionDetails() {
@@ -2720,7 +7099,8 @@ void UpdateIgnoredAlertsSelectionDetails() {
     return;
   }
 
-  const std::wstring details = IgnoreRuleDetailsText(g_state.ignoredRules[selectedIndex]);
+  const IgnoreRule& rule = g_state.ignoredRules[selectedIndex];
+  const std::wstring details = IgnoreRuleDetailsText(rule, FindIgnoreRuleStats(rule));
   SetWindowTextW(g_state.ignoredAlertsDetailsHwnd, details.c_str());
   EnableWindow(g_state.refreshIgnoredButtonHwnd, TRUE);
 }
@@ -2740,6 +7120,7 @@ void UpdateAlertManagerVisibleTab() {
   ShowWindow(g_state.ignoredAlertsDetailsHwnd, showMessages ? SW_HIDE : SW_SHOW);
   ShowWindow(g_state.refreshIgnoredButtonHwnd, showMessages ? SW_HIDE : SW_SHOW);
   ShowWindow(g_state.openIgnoreFileButtonHwnd, showMessages ? SW_HIDE : SW_SHOW);
+  ShowWindow(g_state.exportIgnoreStatsButtonHwnd, showMessages ? SW_HIDE : SW_SHOW);
   ShowWindow(g_state.ignoreUsageHintHwnd, showMessages ? SW_HIDE : SW_SHOW);
 
   if (showMessages) {
@@ -2781,10 +7162,11 @@ void LayoutAlertManagerControls() {
   const int buttonX = tabContentRect.left + listWidth + kAlertManagerPaddingPx;
   const int buttonY = tabContentRect.top;
   const int secondButtonY = buttonY + kAlertManagerButtonHeight + kAlertManagerButtonSpacingPx;
-  const int usageHintY = secondButtonY + kAlertManagerButtonHeight + kAlertManagerButtonSpacingPx;
+  const int thirdButtonY = secondButtonY + kAlertManagerButtonHeight + kAlertManagerButtonSpacingPx;
+  const int usageHintY = thirdButtonY + kAlertManagerButtonHeight + kAlertManagerButtonSpacingPx;
   const int usageHintHeight = (std::max)(
       0,
-      listHeight - ((kAlertManagerButtonHeight * 2) + (kAlertManagerButtonSpacingPx * 2)));
+      listHeight - ((kAlertManagerButtonHeight * 3) + (kAlertManagerButtonSpacingPx * 3)));
   const int detailsY = tabContentRect.top + listHeight + kAlertManagerPaddingPx;
 
   SetWindowPos(
@@ -2827,6 +7209,14 @@ void LayoutAlertManagerControls() {
       kAlertManagerButtonWidth,
       kAlertManagerButtonHeight,
       SWP_NOZORDER);
+  SetWindowPos(
+      g_state.exportIgnoreStatsButtonHwnd,
+      nullptr,
+      buttonX,
+      thirdButtonY,
+      kAlertManagerButtonWidth,
+      kAlertManagerButtonHeight,
+      SWP_NOZORDER);
   SetWindowPos(
       g_state.ignoreUsageHintHwnd,
       nullptr,
@@ -2860,19 +7250,13 @@ void RefreshAlertManagerWindowContent() {
 
   if (g_state.activeAlertsListHwnd) {
     SendMessageW(g_state.activeAlertsListHwnd, LB_RESETCONTENT, 0, 0);
-    for (int sourceIndex = static_cast<int>(g_state.activeAlertEntries.size()) - 1; sourceIndex >= 0; --sourceIndex) {
-      const AlertEntry& entry = g_state.activeAlertEntries[sourceIndex];
-      const int listIndex = static_cast<int>(SendMessageW(
-          g_state.activeAlertsListHwnd,
-          LB_ADDSTRING,
-          0,
-          reinterpret_cast<LPARAM>(entry.listText.c_str())));
-      if (listIndex >= 0) {
-        SendMessageW(g_state.activeAlertsListHwnd, LB_SETITEMDATA, static_cast<WPARAM>(listIndex), sourceIndex);
-      }
-    }
-    UpdateListBoxHorizontalExtent(g_state.activeAlertsListHwnd);
-    if (!g_state.activeAlertEntries.empty()) {
+    SendMessageW(
+        g_state.activeAlertsListHwnd,
+        LB_SETCOUNT,
+        static_cast<WPARAM>(AlertCount(g_state.activeAlerts)),
+        0);
+    UpdateActiveAlertsListHorizontalExtent();
+    if (AlertCount(g_state.activeAlerts) != 0) {
       SendMessageW(g_state.activeAlertsListHwnd, LB_SETCURSEL, 0, 0);
     }
   }
@@ -2880,7 +7264,8 @@ void RefreshAlertManagerWindowContent() {
   if (g_state.ignoredAlertsListHwnd) {
     SendMessageW(g_state.ignoredAlertsListHwnd, LB_RESETCONTENT, 0, 0);
     for (size_t i = 0; i < g_state.ignoredRules.size(); ++i) {
-      const std::wstring displayText = IgnoreRuleDisplayText(g_state.ignoredRules[i]);
+      const std::wstring displayText =
+          IgnoreRuleDisplayText(g_state.ignoredRules[i], FindIgnoreRuleStats(g_state.ignoredRules[i]));
       const int listIndex = static_cast<int>(SendMessageW(
           g_state.ignoredAlertsListHwnd,
           LB_ADDSTRING,
@@ -2900,25 +7285,21 @@ void RefreshAlertManagerWindowContent() {
 }
 
 void OpenSelectedActiveAlertInLog() {
-  const size_t selectedIndex = SelectedListItemDataIndex(
-      g_state.activeAlertsListHwnd,
-      g_state.activeAlertEntries.size());
-  if (selectedIndex >= g_state.activeAlertEntries.size()) {
+  const size_t selectedIndex = SelectedActiveAlertIndex();
+  if (selectedIndex >= AlertCount(g_state.activeAlerts)) {
     return;
   }
 
-  const AlertEntry& entry = g_state.activeAlertEntries[selectedIndex];
+  const AlertView alert = StoredAlertView(&g_state.activeAlerts, selectedIndex);
   DebugLog(
-      L"OpenSelectedActiveAlertInLog requested. line=" + std::to_wstring(entry.lineNumber) +
-      L", summary=" + entry.summaryText);
-  OpenLogFileAtLine(entry.lineNumber);
+      L"OpenSelectedActiveAlertInLog requested. line=" + std::to_wstring(alert.lastLineNumber) +
+      L", summary=" + AlertSummaryText(alert));
+  OpenLogFileAtLine(alert.lastLineNumber);
 }
 
 void IgnoreSelectedActiveAlert() {
-  const size_t selectedIndex = SelectedListItemDataIndex(
-      g_state.activeAlertsListHwnd,
-      g_state.activeAlertEntries.size());
-  if (selectedIndex >= g_state.activeAlertEntries.size()) {
+  const size_t selectedIndex = SelectedActiveAlertIndex();
+  if (selectedIndex >= AlertCount(g_state.activeAlerts)) {
     MessageBoxW(
         g_state.alertManagerHwnd,
         L"Select a warn/error message to ignore first.",
@@ -2927,8 +7308,8 @@ void IgnoreSelectedActiveAlert() {
     return;
   }
 
-  const AlertEntry selectedEntry = g_state.activeAlertEntries[selectedIndex];
-  if (selectedEntry.isIgnored) {
+  const AlertView selectedAlert = StoredAlertView(&g_state.activeAlerts, selectedIndex);
+  if (selectedAlert.isIgnored) {
     MessageBoxW(
         g_state.alertManagerHwnd,
         L"This message already matches Ignore.txt.",
@@ -2936,11 +7317,13 @@ void IgnoreSelectedActiveAlert() {
         MB_ICONINFORMATION | MB_OK);
     return;
   }
-  DebugLog(L"IgnoreSelectedActiveAlert requested for " + selectedEntry.summaryText);
-  if (selectedEntry.severity == AlertSeverity::kError) {
+  const std::wstring summaryText = AlertSummaryText(selectedAlert);
+  const std::string ignoreRuleText = BuildSuggestedIgnoreRuleText(selectedAlert);
+  DebugLog(L"IgnoreSelectedActiveAlert requested for " + summaryText);
+  if (selectedAlert.severity == AlertSeverity::kError) {
     std::wstring confirmText =
         L"Ignore this error message?\r\n\r\nSummary:\r\n" +
-        selectedEntry.summaryText;
+        summaryText;
     if (MessageBoxW(
             g_state.alertManagerHwnd,
             confirmText.c_str(),
@@ -2950,15 +7333,15 @@ void IgnoreSelectedActiveAlert() {
     }
   }
 
-  AddIgnoredAlertRule(selectedEntry.ignoreRuleText);
-  ResetWatcherAndRescan();
+  AddIgnoredAlertRule(ignoreRuleText);
+  ReclassifyAlertsWithCurrentRules();
   DebugLog(L"IgnoreSelectedActiveAlert completed.");
 }
 
 void RefreshIgnoreListFromDisk() {
   DebugLog(L"RefreshIgnoreListFromDisk requested.");
   ReloadIgnoreListIfChanged(true);
-  ResetWatcherAndRescan();
+  ReclassifyAlertsWithCurrentRules();
 }
 
 LRESULT CALLBACK AlertManagerWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam) {
@@ -2994,7 +7377,8 @@ LRESULT CALLBACK AlertManagerWindowProc(HWND hwnd, UINT message, WPARAM wParam,
           WS_EX_CLIENTEDGE,
           L"LISTBOX",
           L"",
-          WS_CHILD | WS_VISIBLE | WS_TABSTOP | LBS_NOTIFY | WS_VSCROLL | WS_HSCROLL | LBS_NOINTEGRALHEIGHT,
+          WS_CHILD | WS_VISIBLE | WS_TABSTOP | LBS_NOTIFY | WS_VSCROLL | WS_HSCROLL | LBS_NOINTEGRALHEIGHT |
+              LBS_OWNERDRAWFIXED | LBS_NODATA,
           0,
           0,
           0,
@@ -3082,6 +7466,19 @@ LRESULT CALLBACK AlertManagerWindowProc(HWND hwnd, UINT message, WPARAM wParam,
           MenuHandleFromId(kControlOpenIgnoreFileButton),
           nullptr,
           nullptr);
+      g_state.exportIgnoreStatsButtonHwnd = CreateWindowExW(
+          0,
+          L"BUTTON",
+          L"Export rule stats",
+          WS_CHILD | WS_VISIBLE | WS_TABSTOP,
+          0,
+          0,
+          0,
+          0,
+          hwnd,
+          MenuHandleFromId(kControlExportIgnoreStatsButton),
+          nullptr,
+          nullptr);
       g_state.ignoreUsageHintHwnd = CreateWindowExW(
           WS_EX_CLIENTEDGE,
           L"EDIT",
@@ -3105,6 +7502,13 @@ LRESULT CALLBACK AlertManagerWindowProc(HWND hwnd, UINT message, WPARAM wParam,
       LayoutAlertManagerControls();
       return 0;
 
+    case WM_DRAWITEM:
+      if (wParam == kControlActiveAlertsList) {
+        DrawActiveAlertsListItem(reinterpret_cast<const DRAWITEMSTRUCT*>(lParam));
+        return TRUE;
+      }
+      break;
+
     case WM_NOTIFY:
       if (reinterpret_cast<NMHDR*>(lParam)->idFrom == kControlAlertTab &&
           reinterpret_cast<NMHDR*>(lParam)->code == TCN_SELCHANGE) {
@@ -3136,6 +7540,9 @@ LRESULT CALLBACK AlertManagerWindowProc(HWND hwnd, UINT message, WPARAM wParam,
         case kControlOpenIgnoreFileButton:
           OpenIgnoreListFile();
           return 0;
+        case kControlExportIgnoreStatsButton:
+          ExportIgnoreRuleStats();
+          return 0;
         default:
           return DefWindowProcW(hwnd, message, wParam, lParam);
       }
@@ -3154,6 +7561,7 @@ LRESULT CALLBACK AlertManagerWindowProc(HWND hwnd, UINT message, WPARAM wParam,
       g_state.ignoredAlertsDetailsHwnd = nullptr;
       g_state.refreshIgnoredButtonHwnd = nullptr;
       g_state.openIgnoreFileButtonHwnd = nullptr;
+      g_state.exportIgnoreStatsButtonHwnd = nullptr;
       g_state.ignoreUsageHintHwnd = nullptr;
       return 0;
 
@@ -3187,8 +7595,8 @@ bool EnsureAlertManagerWindowClassRegistered() {
 
 void ShowAlertManagerWindow() {
   if (ReloadIgnoreListIfChanged(false)) {
-    DebugLog(L"ShowAlertManagerWindow noticed Ignore.txt changed. Rescanning log.");
-    ResetWatcherAndRescan();
+    DebugLog(L"ShowAlertManagerWindow noticed Ignore.txt changed. Reclassifying alerts.");
+    ReclassifyAlertsWithCurrentRules();
   }
 
   if (g_state.alertManagerHwnd && IsWindow(g_state.alertManagerHwnd)) {
@@ -3234,7 +7642,14 @@ void ApplySelectedLogPath(const std::wstring& selectedPath) {
   SaveLogPathToConfig(g_state.logPath);
   g_state.acknowledgedOffset = 0;
   SaveAcknowledgedOffsetToConfig(g_state.acknowledgedOffset);
-  ResetWatcherAndRescan();
+  StartLogChangeNotifier();
+  ApplyMonitorInterval();
+
+  auto command = std::make_unique<ScanCommand>();
+  command->kind = ScanCommandKind::kSetLogPath;
+  command->logPath = g_state.logPath;
+  command->ignoreRules = SnapshotIgnoreRules();
+  PostScanCommand(std::move(command));
 }
 
 void ChooseLogPath() {
@@ -3389,6 +7804,7 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lPara
   switch (message) {
     case WM_TIMER:
       if (wParam == kMonitorTimerId) {
+        RetryLogChangeNotifierIfStopped();
         MonitorLogFileOnce();
       } else if (wParam == kBlinkTimerId) {
         if (ShouldBlinkForSeverity(g_state.alertSeverity)) {
@@ -3412,6 +7828,19 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lPara
       return 0;
     }
 
+    case kScanResultsMessage:
+      ApplyScanBatches();
+      return 0;
+
+    case kLogChangedMessage:
+      if (wParam == kLogChangeNotifierStopped) {
+        StopLogChangeNotifier();
+        ApplyMonitorInterval();
+      }
+      g_state.logChangePending.store(false);
+      MonitorLogFileOnce();
+      return 0;
+
     case WM_COMMAND: {
       if (HandleCommand(LOWORD(wParam))) {
         return 0;
@@ -3421,6 +7850,7 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lPara
 
     case WM_DESTROY:
       KillTimer(hwnd, kMonitorTimerId);
+      StopLogChangeNotifier();
       KillTimer(hwnd, kBlinkTimerId);
       if (g_state.acknowledgePopupHwnd && IsWindow(g_state.acknowledgePopupHwnd)) {
         DestroyWindow(g_state.acknowledgePopupHwnd);
@@ -3439,6 +7869,7 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lPara
         g_state.normalIcon = nullptr;
         g_state.ownsNormalIcon = false;
       }
+      StopScannerThread();
       PostQuitMessage(0);
       return 0;
 
@@ -3471,6 +7902,8 @@ int WINAPI wWinMain(HINSTANCE instance, HINSTANCE, PWSTR, int) {
   g_state.configPath = ConfigFilePath();
   g_state.ignorePath = IgnoreFilePath();
   g_state.debugLogPath = DebugLogPath();
+  g_state.lineIndexPath = LineIndexFilePath();
+  g_state.alertSpillPath = AlertSpillFilePath();
   LoadLogPathFromConfig();
   ReloadIgnoreListIfChanged(true);
 
@@ -3510,6 +7943,13 @@ int WINAPI wWinMain(HINSTANCE instance, HINSTANCE, PWSTR, int) {
   }
 
   g_state.hwnd = hwnd;
+  if (!StartScannerThread()) {
+    MessageBoxW(hwnd, L"Failed to start log scanner.", L"Backrest Watcher", MB_ICONERROR | MB_OK);
+    DestroyWindow(hwnd);
+    ReleaseSingleInstanceLock();
+    return 1;
+  }
+  StartLogChangeNotifier();
 
   if (!InitializeTrayIcon(hwnd)) {
     MessageBoxW(hwnd, L"Failed to add tray icon.", L"Backrest Watcher", MB_ICONERROR | MB_OK);
@@ -3518,7 +7958,7 @@ int WINAPI wWinMain(HINSTANCE instance, HINSTANCE, PWSTR, int) {
     return 1;
   }
 
-  if (SetTimer(hwnd, kMonitorTimerId, g_state.monitorIntervalMs, nullptr) == 0) {
+  if (SetTimer(hwnd, kMonitorTimerId, EffectiveMonitorIntervalMs(), nullptr) == 0) {
     MessageBoxW(hwnd, L"Failed to start log monitoring timer.", L"Backrest Watcher", MB_ICONERROR | MB_OK);
     DestroyWindow(hwnd);
     ReleaseSingleInstanceLock();
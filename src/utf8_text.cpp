@@ -0,0 +1,87 @@
+#include "utf8_text.h"
+
+namespace backrest_watcher {
+
+size_t WidenAsciiScalar(const char* text, size_t size, wchar_t* out) {
+  size_t pos = 0;
+  while (pos < size && static_cast<unsigned char>(text[pos]) < 0x80) {
+    out[pos] = static_cast<wchar_t>(text[pos]);
+    ++pos;
+  }
+  return pos;
+}
+
+size_t DecodeUtf8Sequence(const unsigned char* bytes, size_t size, char32_t* outCodePoint) {
+  *outCodePoint = 0xFFFD;
+  const unsigned char lead = bytes[0];
+  size_t length = 0;
+  unsigned char secondMin = 0x80;
+  unsigned char secondMax = 0xBF;
+  char32_t codePoint = 0;
+  if (lead < 0x80) {
+    *outCodePoint = lead;
+    return 1;
+  } else if (lead >= 0xC2 && lead <= 0xDF) {
+    length = 2;
+    codePoint = lead & 0x1F;
+  } else if (lead >= 0xE0 && lead <= 0xEF) {
+    length = 3;
+    codePoint = lead & 0x0F;
+    secondMin = lead == 0xE0 ? 0xA0 : 0x80;
+    secondMax = lead == 0xED ? 0x9F : 0xBF;
+  } else if (lead >= 0xF0 && lead <= 0xF4) {
+    length = 4;
+    codePoint = lead & 0x07;
+    secondMin = lead == 0xF0 ? 0x90 : 0x80;
+    secondMax = lead == 0xF4 ? 0x8F : 0xBF;
+  } else {
+    return 1;
+  }
+
+  for (size_t i = 1; i < length; ++i) {
+    if (i >= size) {
+      return i;
+    }
+    const unsigned char minByte = i == 1 ? secondMin : 0x80;
+    const unsigned char maxByte = i == 1 ? secondMax : 0xBF;
+    if (bytes[i] < minByte || bytes[i] > maxByte) {
+      return i;
+    }
+    codePoint = (codePoint << 6) | (bytes[i] & 0x3F);
+  }
+  *outCodePoint = codePoint;
+  return length;
+}
+
+// The output never has more characters than the input has bytes, so out is grown once.
+void AppendUtf8AsWide(std::string_view text, WidenAsciiKernel widenAscii, std::wstring* out) {
+  const size_t start = out->size();
+  out->resize(start + text.size());
+  wchar_t* dest = out->data() + start;
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(text.data());
+  size_t pos = 0;
+  size_t written = 0;
+  while (true) {
+    const size_t asciiLength = widenAscii(text.data() + pos, text.size() - pos, dest + written);
+    pos += asciiLength;
+    written += asciiLength;
+    if (pos >= text.size()) {
+      break;
+    }
+
+    char32_t codePoint = 0;
+    pos += DecodeUtf8Sequence(bytes + pos, text.size() - pos, &codePoint);
+    if constexpr (sizeof(wchar_t) == 2) {
+      if (codePoint >= 0x10000) {
+        codePoint -= 0x10000;
+        dest[written++] = static_cast<wchar_t>(0xD800 + (codePoint >> 10));
+        dest[written++] = static_cast<wchar_t>(0xDC00 + (codePoint & 0x3FF));
+        continue;
+      }
+    }
+    dest[written++] = static_cast<wchar_t>(codePoint);
+  }
+  out->resize(start + written);
+}
+
+}  // namespace backrest_watcher
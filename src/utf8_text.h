@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// UTF-8 to wide text conversion without any Win32 dependency, so it also builds and is tested on Linux.
+namespace backrest_watcher {
+
+// Widens the leading ASCII run of text into out and returns its length; stops at the first byte
+// with the high bit set. out must have room for size characters.
+using WidenAsciiKernel = size_t (*)(const char* text, size_t size, wchar_t* out);
+
+size_t WidenAsciiScalar(const char* text, size_t size, wchar_t* out);
+
+// Length of the UTF-8 sequence at the start of bytes and its code point. Malformed input yields
+// U+FFFD for each maximal subpart, the replacement practice Unicode recommends. size must be at least 1.
+size_t DecodeUtf8Sequence(const unsigned char* bytes, size_t size, char32_t* outCodePoint);
+
+// Appends text to out as UTF-16 where wchar_t is 16 bits wide and as UTF-32 otherwise. ASCII runs
+// go through widenAscii, which may be a vector kernel; only the bytes after a high byte are decoded.
+void AppendUtf8AsWide(std::string_view text, WidenAsciiKernel widenAscii, std::wstring* out);
+
+}  // namespace backrest_watcher
@@ -0,0 +1,68 @@
+// Builds without Windows headers:
+//   g++ -std=c++17 -Isrc tests/utf8_text_test.cpp src/utf8_text.cpp -o utf8_text_test && ./utf8_text_test
+
+#include "utf8_text.h"
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+namespace {
+
+int g_failures = 0;
+
+// Stops after at most three characters, so ASCII is also handed to the decoder between kernel calls.
+size_t WidenAsciiThreeAtATime(const char* text, size_t size, wchar_t* out) {
+  return backrest_watcher::WidenAsciiScalar(text, size < 3 ? size : 3, out);
+}
+
+std::wstring Expected(std::u32string_view codePoints) {
+  std::wstring wide;
+  for (const char32_t codePoint : codePoints) {
+    if (sizeof(wchar_t) == 2 && codePoint >= 0x10000) {
+      wide.push_back(static_cast<wchar_t>(0xD800 + ((codePoint - 0x10000) >> 10)));
+      wide.push_back(static_cast<wchar_t>(0xDC00 + ((codePoint - 0x10000) & 0x3FF)));
+    } else {
+      wide.push_back(static_cast<wchar_t>(codePoint));
+    }
+  }
+  return wide;
+}
+
+void Check(const char* name, std::string_view utf8, std::u32string_view codePoints) {
+  const std::wstring expected = Expected(codePoints);
+  const backrest_watcher::WidenAsciiKernel kernels[] = {backrest_watcher::WidenAsciiScalar, WidenAsciiThreeAtATime};
+  for (const auto kernel : kernels) {
+    std::wstring actual = L"<";
+    backrest_watcher::AppendUtf8AsWide(utf8, kernel, &actual);
+    if (actual != L"<" + expected) {
+      std::printf("FAIL %s\n", name);
+      ++g_failures;
+      return;
+    }
+  }
+}
+
+}  // namespace
+
+int main() {
+  Check("empty", "", U"");
+  Check("ascii", "level=warn msg=\"disk full\"", U"level=warn msg=\"disk full\"");
+  Check("two byte", "caf\xC3\xA9", U"caf\u00E9");
+  Check("three byte", "\xE2\x82\xAC 5", U"\u20AC 5");
+  Check("four byte", "a\xF0\x9F\x98\x80z", U"a\U0001F600z");
+  Check("surrogate pair boundary", "\xF0\x90\x80\x80\xF4\x8F\xBF\xBF", U"\U00010000\U0010FFFF");
+  Check("stray continuation", "a\x80z", U"a\uFFFDz");
+  Check("invalid lead", "\xC0\xAF\xFF", U"\uFFFD\uFFFD\uFFFD");
+  Check("truncated at end", "ok\xE2\x82", U"ok\uFFFD");
+  Check("truncated before ascii", "\xF0\x9F\x98z", U"\uFFFDz");
+  Check("overlong three byte", "\xE0\x80\xAF", U"\uFFFD\uFFFD\uFFFD");
+  Check("encoded surrogate", "\xED\xA0\x80", U"\uFFFD\uFFFD\uFFFD");
+  Check("above U+10FFFF", "\xF4\x90\x80\x80", U"\uFFFD\uFFFD\uFFFD\uFFFD");
+
+  if (g_failures != 0) {
+    return 1;
+  }
+  std::printf("utf8_text_test: all passed\n");
+  return 0;
+}